@@ -6,6 +6,13 @@ File: network.py
 import numpy as np
 
 
+# Activation options of the FPGA neurons (nn_pkg::ACTIVATION, NN_ACTIVATION)
+ACT_SIGMOID_LUT = 0
+ACT_SIGMOID_INTERP = 1
+ACT_HARD_SIGMOID = 2
+ACT_RELU = 3
+
+
 class NeuralNetwork:
     """Multi-Layer Perceptron Neural Network for FPGA deployment."""
     
@@ -85,6 +92,32 @@ class NeuralNetwork:
                 acc = self.evaluate(X_train, y_train)
                 print(f"Epoch {epoch + 1:3d}/{epochs}, Accuracy: {acc:.4f}")
     
+    def forward_fixed(self, x, activation=ACT_SIGMOID_LUT, frac_bits=11):
+        """Fixed-point forward pass, bit-exact with the FPGA core.
+        
+        x holds one input vector per column. Returns the S.4.11 outputs as
+        integers (one column per input). Mirrors the 32-bit wrapping
+        accumulator, i.e. nn_pkg::MAC_ACC_WIDTH = 32; with 48 the core only
+        matches while no layer's sum leaves the 32-bit range.
+        """
+        x = np.asarray(x)
+        if x.ndim == 1:
+            x = x.reshape(-1, 1)
+        a = to_fixed_array(x, frac_bits)
+        for w, b in zip(self.weights, self.biases):
+            # 32-bit wrapping accumulator, bias pre-shifted to product scale
+            acc = np.dot(to_fixed_array(w, frac_bits), a) + (to_fixed_array(b, frac_bits) << frac_bits)
+            acc = ((acc + (1 << 31)) % (1 << 32)) - (1 << 31)
+            z = np.clip(acc >> frac_bits, -32768, 32767)
+            a = fixed_activation(z, activation, frac_bits)
+        return a
+    
+    def evaluate_fixed(self, X, y, activation=ACT_SIGMOID_LUT, frac_bits=11):
+        """Accuracy of the fixed-point model (first maximum wins, as on the FPGA)."""
+        pred = np.argmax(self.forward_fixed(X, activation, frac_bits), axis=0)
+        labels = np.argmax(y, axis=0)
+        return np.mean(pred == labels)
+    
     def predict(self, x):
         """Make prediction."""
         return np.argmax(self.forward(x)[-1], axis=0)
@@ -95,8 +128,14 @@ class NeuralNetwork:
         labels = np.argmax(y, axis=0)
         return np.mean(pred == labels)
     
-    def export_for_fpga(self, output_dir, filename="nn_model", frac_bits=11):
-        """Export weights/biases in fixed-point format for FPGA."""
+    def export_for_fpga(self, output_dir, filename="nn_model", frac_bits=11,
+                        lanes=2, in_parallel=4, df_lanes=(16, 2, 2)):
+        """Export weights/biases in fixed-point format for FPGA.
+        
+        lanes and in_parallel must match nn_pkg::NUM_PARALLEL and
+        nn_pkg::IN_PARALLEL for the per-lane weight bank files, df_lanes
+        nn_pkg::DF_L*_PARALLEL for the dataflow engines' bank files.
+        """
         import os
         os.makedirs(output_dir, exist_ok=True)
         
@@ -122,6 +161,47 @@ class NeuralNetwork:
                         f.write(to_hex(to_fixed(val)) + "\n")
                 f.write("\n")
         
+        # Export per-lane weight banks: lane l holds rows n % lanes == l, one
+        # group slot per neuron group, each row padded to whole words of
+        # in_parallel weights (first weight in the low bits)
+        lane_files = []
+        for lane in range(lanes):
+            lane_file = os.path.join(output_dir, f"{filename}_weights_lane{lane}.mem")
+            with open(lane_file, 'w') as f:
+                f.write(f"// Neural Network Weights, lane {lane} of {lanes} "
+                        f"({in_parallel} x S.4.11 per word)\n\n")
+                for layer_idx, w in enumerate(self.weights):
+                    words = -(-w.shape[1] // in_parallel)
+                    groups = -(-w.shape[0] // lanes)
+                    f.write(f"// Layer {layer_idx}: {groups} groups x {words} words\n")
+                    for g in range(groups):
+                        n = g * lanes + lane
+                        row = [to_fixed(v) for v in w[n]] if n < w.shape[0] else []
+                        row += [0] * (words * in_parallel - len(row))
+                        for i in range(0, len(row), in_parallel):
+                            chunk = row[i:i + in_parallel]
+                            f.write("".join(to_hex(v) for v in reversed(chunk)) + "\n")
+                    f.write("\n")
+            lane_files.append(lane_file)
+        
+        # Export the dataflow engines' banks: per layer and lane, one weight
+        # per word, rows of neurons n % lanes == lane one group after the
+        # other (missing rows of the last group are zero)
+        for layer_idx, (w, eng_lanes) in enumerate(zip(self.weights, df_lanes)):
+            groups = -(-w.shape[0] // eng_lanes)
+            for lane in range(eng_lanes):
+                lane_file = os.path.join(
+                    output_dir, f"{filename}_weights_df_l{layer_idx}_lane{lane}.mem")
+                with open(lane_file, 'w') as f:
+                    f.write(f"// Neural Network Weights, layer {layer_idx}, "
+                            f"dataflow lane {lane} of {eng_lanes} (S.4.11)\n")
+                    f.write(f"// {groups} groups x {w.shape[1]} weights\n\n")
+                    for g in range(groups):
+                        n = g * eng_lanes + lane
+                        for i in range(w.shape[1]):
+                            f.write(to_hex(to_fixed(w[n][i]) if n < w.shape[0] else 0) + "\n")
+                lane_files.append(lane_file)
+        
         # Export biases
         biases_file = os.path.join(output_dir, f"{filename}_biases.mem")
         with open(biases_file, 'w') as f:
@@ -147,6 +227,54 @@ class NeuralNetwork:
             f.write(f"#endif\n")
         
         print(f"Exported: {weights_file}, {biases_file}, {header_file}")
+        print(f"Exported: {len(lane_files)} weight bank files ({filename}_weights_lane*.mem, "
+              f"{filename}_weights_df_l*_lane*.mem)")
+
+
+def to_fixed_array(a, frac_bits=11):
+    """Round to S.4.11 integers, saturated to 16 bits."""
+    return np.clip(np.round(np.asarray(a) * (2 ** frac_bits)), -32768, 32767).astype(np.int64)
+
+
+def sigmoid_lut_table(num_entries=1024, frac_bits=11):
+    """Entries of sigmoid_lut.mem: sigmoid over [-8, +8], end points included."""
+    x = np.arange(num_entries) / (num_entries - 1) * 16.0 - 8.0
+    return np.round(1.0 / (1.0 + np.exp(-x)) * (2 ** frac_bits)).astype(np.int64)
+
+
+def sigmoid_interp_table(segments=64, frac_bits=11):
+    """Entries of sigmoid_interp.mem: sigmoid at the segment end points."""
+    x = np.arange(segments + 1) * (16.0 / segments) - 8.0
+    return np.round(1.0 / (1.0 + np.exp(-x)) * (2 ** frac_bits)).astype(np.int64)
+
+
+def fixed_activation(z, activation=ACT_SIGMOID_LUT, frac_bits=11,
+                     lut_entries=1024, segments=64):
+    """Activation of S.4.11 integers, bit-exact with nn_neuron/nn_activation."""
+    z = np.asarray(z, dtype=np.int64)
+    u = z + (8 << frac_bits)                    # x + 8.0
+    top = (16 << frac_bits) - 1
+    
+    if activation == ACT_SIGMOID_LUT:
+        shift = frac_bits + 4 - int(np.log2(lut_entries))
+        return sigmoid_lut_table(lut_entries, frac_bits)[np.clip(u, 0, top) >> shift]
+    
+    if activation == ACT_SIGMOID_INTERP:
+        t = sigmoid_interp_table(segments, frac_bits)
+        frac_w = frac_bits + 4 - int(np.log2(segments))
+        uc = np.clip(u, 0, top)
+        k = uc >> frac_w
+        f = uc & ((1 << frac_w) - 1)
+        y = t[k] + (((t[np.minimum(k + 1, segments)] - t[k]) * f) >> frac_w)
+        return np.where(u < 0, t[0], np.where(u > top, t[segments], y))
+    
+    if activation == ACT_HARD_SIGMOID:
+        return np.clip((z >> 2) + (1 << (frac_bits - 1)), 0, 1 << frac_bits)
+    
+    if activation == ACT_RELU:
+        return np.maximum(z, 0)
+    
+    raise ValueError(f"unknown activation {activation}")
 
 
 def generate_sigmoid_lut(output_dir, filename="sigmoid_lut", num_entries=1024, frac_bits=11):
@@ -154,17 +282,31 @@ def generate_sigmoid_lut(output_dir, filename="sigmoid_lut", num_entries=1024, f
     import os
     os.makedirs(output_dir, exist_ok=True)
     
-    scale = 2 ** frac_bits
     filepath = os.path.join(output_dir, f"{filename}.mem")
     
     with open(filepath, 'w') as f:
         f.write(f"// Sigmoid LUT: {num_entries} entries\n")
         f.write("// Input: -8.0 to +8.0, Output: 0.0 to 1.0\n\n")
         
-        for i in range(num_entries):
-            x = (i / (num_entries - 1)) * 16.0 - 8.0
-            y = 1.0 / (1.0 + np.exp(-x))
-            f.write(format(int(round(y * scale)), '04X') + "\n")
+        for y in sigmoid_lut_table(num_entries, frac_bits):
+            f.write(format(int(y), '04X') + "\n")
+    
+    print(f"Generated: {filepath}")
+
+
+def generate_sigmoid_interp(output_dir, filename="sigmoid_interp", segments=64, frac_bits=11):
+    """Generate the segment end points of the interpolated sigmoid."""
+    import os
+    os.makedirs(output_dir, exist_ok=True)
+    
+    filepath = os.path.join(output_dir, f"{filename}.mem")
+    
+    with open(filepath, 'w') as f:
+        f.write(f"// Interpolated sigmoid: {segments} segments, {segments + 1} end points\n")
+        f.write("// Input: -8.0 to +8.0, Output: 0.0 to 1.0\n\n")
+        
+        for y in sigmoid_interp_table(segments, frac_bits):
+            f.write(format(int(y), '04X') + "\n")
     
     print(f"Generated: {filepath}")
 
@@ -9,12 +9,14 @@ This script:
 1. Loads MNIST dataset
 2. Trains a neural network
 3. Exports weights for FPGA deployment
-4. Generates sigmoid LUT and test images
+4. Generates sigmoid tables and test images
 """
 
 import numpy as np
 import os
-from network import NeuralNetwork, generate_sigmoid_lut, generate_test_images
+from network import (NeuralNetwork, generate_sigmoid_lut, generate_sigmoid_interp,
+                     generate_test_images, ACT_SIGMOID_LUT, ACT_SIGMOID_INTERP,
+                     ACT_HARD_SIGMOID, ACT_RELU)
 
 
 def load_mnist():
@@ -75,21 +77,33 @@ def main():
     test_acc = nn.evaluate(X_test, y_test)
     print(f"\nTest Accuracy: {test_acc:.4f} ({test_acc*100:.2f}%)")
     
+    # Bit-exact FPGA accuracy for each activation option (nn_pkg::ACTIVATION)
+    for name, act in (("sigmoid LUT", ACT_SIGMOID_LUT),
+                      ("sigmoid interp", ACT_SIGMOID_INTERP),
+                      ("hard sigmoid", ACT_HARD_SIGMOID),
+                      ("ReLU", ACT_RELU)):
+        acc = nn.evaluate_fixed(X_test, y_test, act)
+        print(f"  FPGA fixed-point, {name:14s}: {acc*100:.2f}%")
+    
     # Export for FPGA
     print("\nExporting for FPGA...")
     print("-" * 40)
     
-    nn.export_for_fpga(output_dir, "nn_model", frac_bits=11)
+    nn.export_for_fpga(output_dir, "nn_model", frac_bits=11, lanes=2, in_parallel=4,
+                       df_lanes=(16, 2, 2))
     generate_sigmoid_lut(output_dir, "sigmoid_lut", num_entries=1024, frac_bits=11)
+    generate_sigmoid_interp(output_dir, "sigmoid_interp", segments=64, frac_bits=11)
     generate_test_images(sw_output_dir, X_test, y_test, frac_bits=11)
     
     print("-" * 40)
     print("\nDone! Generated files:")
     print(f"  RTL memory files: {output_dir}")
     print(f"    - nn_model_weights.mem")
+    print(f"    - nn_model_weights_lane*.mem")
     print(f"    - nn_model_biases.mem")
     print(f"    - nn_model_config.h")
     print(f"    - sigmoid_lut.mem")
+    print(f"    - sigmoid_interp.mem")
     print(f"  Software files: {sw_output_dir}")
     print(f"    - test_images.h")
     print("=" * 60)
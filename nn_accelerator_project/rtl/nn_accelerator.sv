@@ -1,262 +1,419 @@
 `timescale 1ns / 1ps
 
 //////////////////////////////////////////////////////////////////////////////////
-// AXI4-Lite Wrapper for NN Accelerator
-// This module provides memory-mapped register interface for control/status
+// NN Accelerator Top Level
+// AXI4-Lite register interface for control/status, AXI4-Stream for data.
+// Input vectors arrive on s_axis (from axi_dma MM2S), results leave on
+// m_axis (to axi_dma S2MM). m_axis_tuser carries {class, margin, score}
+// with every result beat for consumers that want the argmax in-band.
 //////////////////////////////////////////////////////////////////////////////////
 
-module nn_accelerator_axi #(
+module nn_accelerator
+    import nn_pkg::*;
+#(
     // Parameters for AXI-Lite interface
     parameter C_S_AXI_DATA_WIDTH = 32,
-    parameter C_S_AXI_ADDR_WIDTH = 8,
-    
-    // NN Accelerator parameters
-    parameter INPUT_SIZE = 784,      // 28x28 MNIST
-    parameter HIDDEN_SIZE = 128,
-    parameter OUTPUT_SIZE = 10,
-    parameter DATA_WIDTH = 16
+    parameter C_S_AXI_ADDR_WIDTH = 6,
+
+    // Parameters for AXI-Stream interfaces
+    parameter C_AXIS_DATA_WIDTH  = 32,
+
+    // Compute core: 0 = layer-sequential, 1 = layer-pipelined dataflow
+    parameter int DATAFLOW       = nn_pkg::DATAFLOW
 )(
+    input  wire                             aclk,
+    input  wire                             aresetn,
+
     // AXI4-Lite Slave Interface
-    input  wire                             S_AXI_ACLK,
-    input  wire                             S_AXI_ARESETN,
-    
-    // Write Address Channel
-    input  wire [C_S_AXI_ADDR_WIDTH-1:0]   S_AXI_AWADDR,
-    input  wire [2:0]                       S_AXI_AWPROT,
-    input  wire                             S_AXI_AWVALID,
-    output wire                             S_AXI_AWREADY,
-    
-    // Write Data Channel
-    input  wire [C_S_AXI_DATA_WIDTH-1:0]   S_AXI_WDATA,
-    input  wire [(C_S_AXI_DATA_WIDTH/8)-1:0] S_AXI_WSTRB,
-    input  wire                             S_AXI_WVALID,
-    output wire                             S_AXI_WREADY,
-    
-    // Write Response Channel
-    output wire [1:0]                       S_AXI_BRESP,
-    output wire                             S_AXI_BVALID,
-    input  wire                             S_AXI_BREADY,
-    
-    // Read Address Channel
-    input  wire [C_S_AXI_ADDR_WIDTH-1:0]   S_AXI_ARADDR,
-    input  wire [2:0]                       S_AXI_ARPROT,
-    input  wire                             S_AXI_ARVALID,
-    output wire                             S_AXI_ARREADY,
-    
-    // Read Data Channel
-    output wire [C_S_AXI_DATA_WIDTH-1:0]   S_AXI_RDATA,
-    output wire [1:0]                       S_AXI_RRESP,
-    output wire                             S_AXI_RVALID,
-    input  wire                             S_AXI_RREADY,
-    
+    input  wire [C_S_AXI_ADDR_WIDTH-1:0]   s_axi_awaddr,
+    input  wire [2:0]                       s_axi_awprot,
+    input  wire                             s_axi_awvalid,
+    output wire                             s_axi_awready,
+    input  wire [C_S_AXI_DATA_WIDTH-1:0]   s_axi_wdata,
+    input  wire [(C_S_AXI_DATA_WIDTH/8)-1:0] s_axi_wstrb,
+    input  wire                             s_axi_wvalid,
+    output wire                             s_axi_wready,
+    output wire [1:0]                       s_axi_bresp,
+    output wire                             s_axi_bvalid,
+    input  wire                             s_axi_bready,
+    input  wire [C_S_AXI_ADDR_WIDTH-1:0]   s_axi_araddr,
+    input  wire [2:0]                       s_axi_arprot,
+    input  wire                             s_axi_arvalid,
+    output wire                             s_axi_arready,
+    output wire [C_S_AXI_DATA_WIDTH-1:0]   s_axi_rdata,
+    output wire [1:0]                       s_axi_rresp,
+    output wire                             s_axi_rvalid,
+    input  wire                             s_axi_rready,
+
+    // AXI4-Stream Slave (input vector)
+    input  wire [C_AXIS_DATA_WIDTH-1:0]    s_axis_tdata,
+    input  wire                             s_axis_tvalid,
+    output wire                             s_axis_tready,
+    input  wire                             s_axis_tlast,
+
+    // AXI4-Stream Master (output vector)
+    output wire [C_AXIS_DATA_WIDTH-1:0]    m_axis_tdata,
+    output wire                             m_axis_tvalid,
+    input  wire                             m_axis_tready,
+    output wire                             m_axis_tlast,
+    output wire [RESULT_TUSER_WIDTH-1:0]    m_axis_tuser,
+
     // Interrupt
     output wire                             interrupt
 );
 
     //----------------------------------------------
-    // Register Map
+    // Register Map (word index = byte offset / 4)
     //----------------------------------------------
-    // 0x00: CONTROL    - [0]: start, [1]: reset, [31]: busy
-    // 0x04: STATUS     - [7:0]: predicted digit, [31]: done
-    // 0x08: INPUT_ADDR - Base address for input data
-    // 0x0C: CONFIG     - Configuration register
-    // 0x10-0x1F: Reserved
+    // 0x00: CTRL    - [7]: raw output layer (no activation),
+    //                 [6]: class only (no result stream),
+    //                 [5]: load model (with start, auto-clear),
+    //                 [4]: continuous, [3]: stream, [2]: soft reset,
+    //                 [1]: start (auto-clear), [0]: enable
+    // 0x04: STATUS  - [31:16]: top-2 margin, [11:8]: predicted class
+    //                 (both valid with done),
+    //                 [7:4]: state, [2]: input bank free,
+    //                 [1]: done, [0]: busy
+    // 0x08: NUM_IN  - Number of inputs
+    // 0x0C: NUM_H1  - Hidden layer 1 size
+    // 0x10: NUM_H2  - Hidden layer 2 size
+    // 0x14: NUM_OUT - Number of outputs
+    // 0x18: MODEL_HASH - Driver-written ID of the resident model,
+    //                    cleared when a model load starts (0 = bitstream)
+    // 0x1C: NUM_W   - Weight beats in a model load (rest are biases)
+    // 0x20: IRQ_COUNT   - Raise IRQ after this many completions
+    //                     (0 = IRQ follows DONE)
+    // 0x24: IRQ_TIMEOUT - ...or this many cycles after the first
+    //                     unacknowledged completion (0 = no timeout)
+    // 0x28: IRQ_STATUS  - R: unacknowledged completions,
+    //                     W: acknowledge that many completions
+    // 0x2C: SCORE   - [31:16]: margin (score minus runner-up, unsigned),
+    //                 [15:0]: score of the predicted class (S.4.11)
     //----------------------------------------------
-    
-    localparam ADDR_CONTROL    = 8'h00;
-    localparam ADDR_STATUS     = 8'h04;
-    localparam ADDR_INPUT_ADDR = 8'h08;
-    localparam ADDR_CONFIG     = 8'h0C;
-    
+
+    localparam ADDR_LSB = 2;
+    localparam REG_IDX_WIDTH = C_S_AXI_ADDR_WIDTH - ADDR_LSB;
+
+    localparam [REG_IDX_WIDTH-1:0] REG_CTRL    = 'h0;
+    localparam [REG_IDX_WIDTH-1:0] REG_STATUS  = 'h1;
+    localparam [REG_IDX_WIDTH-1:0] REG_NUM_IN  = 'h2;
+    localparam [REG_IDX_WIDTH-1:0] REG_NUM_H1  = 'h3;
+    localparam [REG_IDX_WIDTH-1:0] REG_NUM_H2  = 'h4;
+    localparam [REG_IDX_WIDTH-1:0] REG_NUM_OUT = 'h5;
+    localparam [REG_IDX_WIDTH-1:0] REG_MODEL_HASH = 'h6;
+    localparam [REG_IDX_WIDTH-1:0] REG_NUM_W   = 'h7;
+    localparam [REG_IDX_WIDTH-1:0] REG_IRQ_COUNT   = 'h8;
+    localparam [REG_IDX_WIDTH-1:0] REG_IRQ_TIMEOUT = 'h9;
+    localparam [REG_IDX_WIDTH-1:0] REG_IRQ_STATUS  = 'hA;
+    localparam [REG_IDX_WIDTH-1:0] REG_SCORE   = 'hB;
+
+    localparam CTRL_ENABLE = 0;
+    localparam CTRL_START  = 1;
+    localparam CTRL_RESET  = 2;
+    localparam CTRL_STREAM = 3;
+    localparam CTRL_CONT   = 4;
+    localparam CTRL_LOAD   = 5;
+    localparam CTRL_CLASS  = 6;
+    localparam CTRL_RAW    = 7;
+
     // Internal Registers
-    reg [C_S_AXI_DATA_WIDTH-1:0] reg_control;
-    reg [C_S_AXI_DATA_WIDTH-1:0] reg_status;
-    reg [C_S_AXI_DATA_WIDTH-1:0] reg_input_addr;
-    reg [C_S_AXI_DATA_WIDTH-1:0] reg_config;
-    
-    // AXI Write State Machine
-    reg [1:0] axi_awstate, axi_wstate;
+    reg [C_S_AXI_DATA_WIDTH-1:0] reg_ctrl;
+    reg [15:0] reg_num_in;
+    reg [15:0] reg_num_h1;
+    reg [15:0] reg_num_h2;
+    reg [15:0] reg_num_out;
+    reg [31:0] reg_model_hash;
+    reg [15:0] reg_num_w;
+    reg [15:0] reg_irq_count;
+    reg [31:0] reg_irq_timeout;
+    reg        start_pulse;
+    reg        load_pulse;
+
+    // Interrupt coalescing
+    reg        nn_done_d;
+    reg [15:0] irq_pending;     // Completions not yet acknowledged
+    reg [31:0] irq_timer;       // Cycles since the oldest pending completion
+    wire       done_rise;
+    wire       irq_ack;
+    wire [15:0] irq_ack_cnt;
+    wire [15:0] irq_pending_nxt;
+
+    // AXI Write Channel
     reg axi_awready_reg, axi_wready_reg, axi_bvalid_reg;
+    reg aw_en;
     reg [C_S_AXI_ADDR_WIDTH-1:0] axi_awaddr_reg;
-    
-    // AXI Read State Machine  
-    reg [1:0] axi_arstate;
+    wire wr_en;
+
+    // AXI Read Channel
     reg axi_arready_reg, axi_rvalid_reg;
     reg [C_S_AXI_ADDR_WIDTH-1:0] axi_araddr_reg;
     reg [C_S_AXI_DATA_WIDTH-1:0] axi_rdata_reg;
-    
-    // NN Accelerator signals
-    wire nn_start;
-    wire nn_reset;
-    wire nn_busy;
-    wire nn_done;
-    wire [3:0] predicted_digit;
-    
-    assign nn_start = reg_control[0];
-    assign nn_reset = reg_control[1] | ~S_AXI_ARESETN;
-    
-    // Update status register
-    always @(posedge S_AXI_ACLK) begin
-        if (~S_AXI_ARESETN) begin
-            reg_status <= 0;
-        end else begin
-            reg_status <= {nn_busy, 23'd0, nn_done, 3'd0, predicted_digit};
-        end
-    end
-    
+
+    // NN Core signals
+    wire    nn_rst_n;
+    wire    nn_busy;
+    wire    nn_done;
+    state_t nn_state;
+    wire [3:0] nn_class;
+    fixed_t    nn_score;
+    wire [15:0] nn_margin;
+    wire    nn_in_ready;
+
+    // Soft reset holds the core in reset for as long as the bit is set
+    assign nn_rst_n = aresetn & ~reg_ctrl[CTRL_RESET];
+
     //----------------------------------------------
     // AXI Write Logic
     //----------------------------------------------
-    assign S_AXI_AWREADY = axi_awready_reg;
-    assign S_AXI_WREADY  = axi_wready_reg;
-    assign S_AXI_BVALID  = axi_bvalid_reg;
-    assign S_AXI_BRESP   = 2'b00; // OKAY response
-    
-    // Write Address Channel
-    always @(posedge S_AXI_ACLK) begin
-        if (~S_AXI_ARESETN) begin
+    assign s_axi_awready = axi_awready_reg;
+    assign s_axi_wready  = axi_wready_reg;
+    assign s_axi_bvalid  = axi_bvalid_reg;
+    assign s_axi_bresp   = 2'b00; // OKAY response
+
+    // Accept address and data together
+    always @(posedge aclk) begin
+        if (~aresetn) begin
             axi_awready_reg <= 1'b0;
-            axi_awstate <= 2'd0;
-            axi_awaddr_reg <= 0;
+            axi_wready_reg  <= 1'b0;
+            axi_awaddr_reg  <= 0;
+            aw_en           <= 1'b1;
         end else begin
-            case (axi_awstate)
-                2'd0: begin // IDLE
-                    axi_awready_reg <= 1'b1;
-                    if (S_AXI_AWVALID && axi_awready_reg) begin
-                        axi_awaddr_reg <= S_AXI_AWADDR;
-                        axi_awready_reg <= 1'b0;
-                        axi_awstate <= 2'd1;
-                    end
-                end
-                2'd1: begin // Wait for write data
-                    if (S_AXI_WVALID && axi_wready_reg) begin
-                        axi_awstate <= 2'd0;
-                    end
+            if (~axi_awready_reg && s_axi_awvalid && s_axi_wvalid && aw_en) begin
+                axi_awready_reg <= 1'b1;
+                axi_wready_reg  <= 1'b1;
+                axi_awaddr_reg  <= s_axi_awaddr;
+                aw_en           <= 1'b0;
+            end else begin
+                axi_awready_reg <= 1'b0;
+                axi_wready_reg  <= 1'b0;
+                if (s_axi_bready && axi_bvalid_reg) begin
+                    aw_en <= 1'b1;
                 end
-            endcase
+            end
         end
     end
-    
-    // Write Data Channel
-    always @(posedge S_AXI_ACLK) begin
-        if (~S_AXI_ARESETN) begin
-            axi_wready_reg <= 1'b0;
-            axi_wstate <= 2'd0;
-            reg_control <= 0;
-            reg_input_addr <= 0;
-            reg_config <= 0;
+
+    assign wr_en = axi_awready_reg && s_axi_awvalid && axi_wready_reg && s_axi_wvalid;
+
+    // Register writes
+    always @(posedge aclk) begin
+        if (~aresetn) begin
+            reg_ctrl    <= 0;
+            reg_num_in  <= DEFAULT_NUM_IN;
+            reg_num_h1  <= DEFAULT_NUM_H1;
+            reg_num_h2  <= DEFAULT_NUM_H2;
+            reg_num_out <= DEFAULT_NUM_OUT;
+            reg_model_hash <= 32'd0;
+            reg_num_w   <= 16'd0;
+            reg_irq_count   <= 16'd0;
+            reg_irq_timeout <= 32'd0;
+            start_pulse <= 1'b0;
+            load_pulse  <= 1'b0;
         end else begin
-            case (axi_wstate)
-                2'd0: begin // IDLE
-                    axi_wready_reg <= 1'b1;
-                    if (S_AXI_WVALID && axi_wready_reg) begin
-                        // Write to register based on address
-                        case (axi_awaddr_reg)
-                            ADDR_CONTROL:    reg_control <= S_AXI_WDATA;
-                            ADDR_INPUT_ADDR: reg_input_addr <= S_AXI_WDATA;
-                            ADDR_CONFIG:     reg_config <= S_AXI_WDATA;
-                            default: ; // Ignore writes to other addresses
-                        endcase
-                        axi_wready_reg <= 1'b0;
-                        axi_wstate <= 2'd1;
+            start_pulse <= 1'b0;
+            load_pulse  <= 1'b0;
+
+            if (wr_en) begin
+                case (axi_awaddr_reg[ADDR_LSB +: REG_IDX_WIDTH])
+                    REG_CTRL: begin
+                        // START and LOAD are pulses and never stored
+                        reg_ctrl    <= s_axi_wdata & ~((1 << CTRL_START) | (1 << CTRL_LOAD));
+                        start_pulse <= s_axi_wdata[CTRL_START];
+                        load_pulse  <= s_axi_wdata[CTRL_START] & s_axi_wdata[CTRL_LOAD];
+                        // A partial upload must never match a model ID
+                        if (s_axi_wdata[CTRL_START] & s_axi_wdata[CTRL_LOAD])
+                            reg_model_hash <= 32'd0;
                     end
-                end
-                2'd1: begin // Send response
-                    axi_wstate <= 2'd0;
-                end
-            endcase
+                    REG_NUM_IN:  reg_num_in  <= s_axi_wdata[15:0];
+                    REG_NUM_H1:  reg_num_h1  <= s_axi_wdata[15:0];
+                    REG_NUM_H2:  reg_num_h2  <= s_axi_wdata[15:0];
+                    REG_NUM_OUT: reg_num_out <= s_axi_wdata[15:0];
+                    REG_MODEL_HASH: reg_model_hash <= s_axi_wdata;
+                    REG_NUM_W:   reg_num_w   <= s_axi_wdata[15:0];
+                    REG_IRQ_COUNT:   reg_irq_count   <= s_axi_wdata[15:0];
+                    REG_IRQ_TIMEOUT: reg_irq_timeout <= s_axi_wdata;
+                    default: ; // Ignore writes to other addresses (IRQ_STATUS below)
+                endcase
+            end
         end
     end
-    
+
     // Write Response Channel
-    always @(posedge S_AXI_ACLK) begin
-        if (~S_AXI_ARESETN) begin
+    always @(posedge aclk) begin
+        if (~aresetn) begin
             axi_bvalid_reg <= 1'b0;
         end else begin
-            if (~axi_bvalid_reg && axi_wstate == 2'd1) begin
+            if (wr_en && ~axi_bvalid_reg) begin
                 axi_bvalid_reg <= 1'b1;
-            end else if (S_AXI_BREADY && axi_bvalid_reg) begin
+            end else if (s_axi_bready && axi_bvalid_reg) begin
                 axi_bvalid_reg <= 1'b0;
             end
         end
     end
-    
+
     //----------------------------------------------
     // AXI Read Logic
     //----------------------------------------------
-    assign S_AXI_ARREADY = axi_arready_reg;
-    assign S_AXI_RVALID  = axi_rvalid_reg;
-    assign S_AXI_RDATA   = axi_rdata_reg;
-    assign S_AXI_RRESP   = 2'b00; // OKAY response
-    
+    assign s_axi_arready = axi_arready_reg;
+    assign s_axi_rvalid  = axi_rvalid_reg;
+    assign s_axi_rdata   = axi_rdata_reg;
+    assign s_axi_rresp   = 2'b00; // OKAY response
+
     // Read Address Channel
-    always @(posedge S_AXI_ACLK) begin
-        if (~S_AXI_ARESETN) begin
+    always @(posedge aclk) begin
+        if (~aresetn) begin
             axi_arready_reg <= 1'b0;
-            axi_arstate <= 2'd0;
-            axi_araddr_reg <= 0;
+            axi_araddr_reg  <= 0;
         end else begin
-            case (axi_arstate)
-                2'd0: begin // IDLE
-                    axi_arready_reg <= 1'b1;
-                    if (S_AXI_ARVALID && axi_arready_reg) begin
-                        axi_araddr_reg <= S_AXI_ARADDR;
-                        axi_arready_reg <= 1'b0;
-                        axi_arstate <= 2'd1;
-                    end
-                end
-                2'd1: begin // Read data
-                    axi_arstate <= 2'd0;
-                end
-            endcase
+            if (~axi_arready_reg && s_axi_arvalid) begin
+                axi_arready_reg <= 1'b1;
+                axi_araddr_reg  <= s_axi_araddr;
+            end else begin
+                axi_arready_reg <= 1'b0;
+            end
         end
     end
-    
+
     // Read Data Channel
-    always @(posedge S_AXI_ACLK) begin
-        if (~S_AXI_ARESETN) begin
+    always @(posedge aclk) begin
+        if (~aresetn) begin
             axi_rvalid_reg <= 1'b0;
-            axi_rdata_reg <= 0;
+            axi_rdata_reg  <= 0;
         end else begin
-            if (~axi_rvalid_reg && axi_arstate == 2'd1) begin
+            if (axi_arready_reg && s_axi_arvalid && ~axi_rvalid_reg) begin
                 axi_rvalid_reg <= 1'b1;
                 // Read from register based on address
-                case (axi_araddr_reg)
-                    ADDR_CONTROL:    axi_rdata_reg <= reg_control;
-                    ADDR_STATUS:     axi_rdata_reg <= reg_status;
-                    ADDR_INPUT_ADDR: axi_rdata_reg <= reg_input_addr;
-                    ADDR_CONFIG:     axi_rdata_reg <= reg_config;
-                    default:         axi_rdata_reg <= 32'hDEADBEEF;
+                case (axi_araddr_reg[ADDR_LSB +: REG_IDX_WIDTH])
+                    REG_CTRL:    axi_rdata_reg <= reg_ctrl;
+                    REG_STATUS:  axi_rdata_reg <= {nn_margin, 4'd0, nn_class, nn_state, 1'b0, nn_in_ready, nn_done, nn_busy};
+                    REG_NUM_IN:  axi_rdata_reg <= {16'd0, reg_num_in};
+                    REG_NUM_H1:  axi_rdata_reg <= {16'd0, reg_num_h1};
+                    REG_NUM_H2:  axi_rdata_reg <= {16'd0, reg_num_h2};
+                    REG_NUM_OUT: axi_rdata_reg <= {16'd0, reg_num_out};
+                    REG_MODEL_HASH: axi_rdata_reg <= reg_model_hash;
+                    REG_NUM_W:   axi_rdata_reg <= {16'd0, reg_num_w};
+                    REG_IRQ_COUNT:   axi_rdata_reg <= {16'd0, reg_irq_count};
+                    REG_IRQ_TIMEOUT: axi_rdata_reg <= reg_irq_timeout;
+                    REG_IRQ_STATUS:  axi_rdata_reg <= {16'd0, irq_pending};
+                    REG_SCORE:   axi_rdata_reg <= {nn_margin, nn_score};
+                    default:     axi_rdata_reg <= 32'hDEADBEEF;
                 endcase
-            end else if (S_AXI_RREADY && axi_rvalid_reg) begin
+            end else if (s_axi_rready && axi_rvalid_reg) begin
                 axi_rvalid_reg <= 1'b0;
             end
         end
     end
-    
+
     //----------------------------------------------
     // Interrupt Generation
     //----------------------------------------------
-    assign interrupt = nn_done;
-    
+    // Every DONE rising edge is one completion. With IRQ_COUNT = 0 the
+    // interrupt follows DONE; otherwise it is raised once IRQ_COUNT
+    // completions are pending or the oldest has waited IRQ_TIMEOUT cycles,
+    // and held until software acknowledges them through IRQ_STATUS.
+    assign done_rise   = nn_done & ~nn_done_d;
+    assign irq_ack     = wr_en && (axi_awaddr_reg[ADDR_LSB +: REG_IDX_WIDTH] == REG_IRQ_STATUS);
+    assign irq_ack_cnt = !irq_ack ? 16'd0 :
+                         (s_axi_wdata[15:0] > irq_pending) ? irq_pending : s_axi_wdata[15:0];
+    assign irq_pending_nxt = irq_pending - irq_ack_cnt +
+                             {15'd0, done_rise && (irq_pending != 16'hFFFF)};
+
+    always @(posedge aclk) begin
+        if (~aresetn) begin
+            nn_done_d   <= 1'b0;
+            irq_pending <= 16'd0;
+            irq_timer   <= 32'd0;
+        end else begin
+            nn_done_d   <= nn_done;
+            irq_pending <= irq_pending_nxt;
+
+            // Restart the timer on acknowledge or when nothing is pending
+            if (irq_pending_nxt == 16'd0 || (irq_ack_cnt != 16'd0))
+                irq_timer <= 32'd0;
+            else if (irq_timer != 32'hFFFFFFFF)
+                irq_timer <= irq_timer + 1;
+        end
+    end
+
+    assign interrupt = (reg_irq_count == 16'd0) ? nn_done :
+                       (irq_pending != 16'd0) &&
+                       ((irq_pending >= reg_irq_count) ||
+                        (reg_irq_timeout != 32'd0 && irq_timer >= reg_irq_timeout));
+
     //----------------------------------------------
     // Instantiate NN Accelerator Core
     //----------------------------------------------
-    nn_accelerator_core #(
-        .INPUT_SIZE(INPUT_SIZE),
-        .HIDDEN_SIZE(HIDDEN_SIZE),
-        .OUTPUT_SIZE(OUTPUT_SIZE),
-        .DATA_WIDTH(DATA_WIDTH)
-    ) nn_core (
-        .clk(S_AXI_ACLK),
-        .rst(nn_reset),
-        .start(nn_start),
-        .busy(nn_busy),
-        .done(nn_done),
-        .predicted_digit(predicted_digit),
-        // Add your actual NN accelerator ports here
-        // e.g., input data interface, weight memory interface, etc.
-        .input_base_addr(reg_input_addr)
-    );
+    if (DATAFLOW) begin : g_dataflow
+        nn_dataflow_core #(
+            .AXIS_DATA_WIDTH(C_AXIS_DATA_WIDTH)
+        ) nn_core (
+            .clk            (aclk),
+            .rst_n          (nn_rst_n),
+            .enable         (reg_ctrl[CTRL_ENABLE]),
+            .start          (start_pulse),
+            .stream         (reg_ctrl[CTRL_STREAM]),
+            .continuous     (reg_ctrl[CTRL_CONT]),
+            .class_only     (reg_ctrl[CTRL_CLASS]),
+            .raw_out        (reg_ctrl[CTRL_RAW]),
+            .load_model     (load_pulse),
+            .busy           (nn_busy),
+            .done           (nn_done),
+            .state          (nn_state),
+            .predicted      (nn_class),
+            .score          (nn_score),
+            .margin         (nn_margin),
+            .in_ready       (nn_in_ready),
+            .num_in         (reg_num_in),
+            .num_h1         (reg_num_h1),
+            .num_h2         (reg_num_h2),
+            .num_out        (reg_num_out),
+            .num_w          (reg_num_w),
+            .s_axis_tdata   (s_axis_tdata),
+            .s_axis_tvalid  (s_axis_tvalid),
+            .s_axis_tready  (s_axis_tready),
+            .s_axis_tlast   (s_axis_tlast),
+            .m_axis_tdata   (m_axis_tdata),
+            .m_axis_tvalid  (m_axis_tvalid),
+            .m_axis_tready  (m_axis_tready),
+            .m_axis_tlast   (m_axis_tlast),
+            .m_axis_tuser   (m_axis_tuser)
+        );
+    end
+    else begin : g_sequential
+        nn_accelerator_core #(
+            .AXIS_DATA_WIDTH(C_AXIS_DATA_WIDTH)
+        ) nn_core (
+            .clk            (aclk),
+            .rst_n          (nn_rst_n),
+            .enable         (reg_ctrl[CTRL_ENABLE]),
+            .start          (start_pulse),
+            .stream         (reg_ctrl[CTRL_STREAM]),
+            .continuous     (reg_ctrl[CTRL_CONT]),
+            .class_only     (reg_ctrl[CTRL_CLASS]),
+            .raw_out        (reg_ctrl[CTRL_RAW]),
+            .load_model     (load_pulse),
+            .busy           (nn_busy),
+            .done           (nn_done),
+            .state          (nn_state),
+            .predicted      (nn_class),
+            .score          (nn_score),
+            .margin         (nn_margin),
+            .in_ready       (nn_in_ready),
+            .num_in         (reg_num_in),
+            .num_h1         (reg_num_h1),
+            .num_h2         (reg_num_h2),
+            .num_out        (reg_num_out),
+            .num_w          (reg_num_w),
+            .s_axis_tdata   (s_axis_tdata),
+            .s_axis_tvalid  (s_axis_tvalid),
+            .s_axis_tready  (s_axis_tready),
+            .s_axis_tlast   (s_axis_tlast),
+            .m_axis_tdata   (m_axis_tdata),
+            .m_axis_tvalid  (m_axis_tvalid),
+            .m_axis_tready  (m_axis_tready),
+            .m_axis_tlast   (m_axis_tlast),
+            .m_axis_tuser   (m_axis_tuser)
+        );
+    end
 
 endmodule
@@ -0,0 +1,837 @@
+//==============================================================================
+// File: nn_accelerator_core.sv
+// Description: Layer-sequential MLP compute core
+//
+// Receives the input vector over AXI4-Stream, evaluates each layer with
+// NUM_PARALLEL neurons at a time and streams the output layer back out.
+//
+// Data format (both streams): one S.4.11 value per beat in tdata[15:0],
+// sign-extended to the full beat width.
+//
+// Input banks: s_axis fills two input banks independently of the FSM, so
+// the next frame streams in while the current one computes.
+// in_ready reports a free bank; a bank is released once layer 0 is done.
+//
+// Streaming layer 0 (STREAM_LAYER0): if S_LOAD_IN finds its bank still
+// empty, it loads group 0's biases and then feeds every accepted pixel to
+// the lanes as it is stored, with the weights read in pixel order. Group 0
+// is complete when the frame is, and the FSM continues at group 1.
+//
+// Zero skipping (ZERO_SKIP): while a frame is stored, the index of every
+// input word holding a nonzero pixel is appended to its bank's list. Layer 0
+// iterates over that list and reads the input and weight words by index,
+// so all-zero words (most of an MNIST digit) cost no MAC cycles.
+//
+// Stream mode: a full input bank starts the inference and the core
+// returns to S_IDLE after the results are sent, so a DMA descriptor chain
+// can feed frames back to back without register writes.
+//
+// Continuous mode: the core returns to S_IDLE after the results are sent,
+// keeping its configuration, so the next START needs no soft reset.
+//
+// Model load: START with load_model set receives a new model on s_axis
+// instead of an input vector. The first num_w beats are weights in the
+// same layer-major order as the .mem files, scattered into the lane banks
+// as they arrive; the remaining beats up to TLAST go to bias_mem. The core
+// then returns to S_IDLE without raising done.
+//
+// Lanes: NUM_PARALLEL (2 to 32, power of two) neurons are generated, each
+// with its own weight bank holding every NUM_PARALLEL-th neuron row of
+// each layer, so all lanes read one shared bank address per cycle. The
+// activation runs in each lane (nn_activation), or with ACT_SIGMOID_LUT in
+// a dual-port sigmoid ROM per lane pair. The bitstream weights come from
+// nn_model_weights_lane<l>.mem, which network.py writes for the same
+// NUM_PARALLEL and IN_PARALLEL.
+//
+// Wide words: bank, input and activation words hold IN_PARALLEL
+// consecutive values, so one read per cycle feeds IN_PARALLEL products to
+// every lane and a group takes ceil(cur_in / IN_PARALLEL) MAC cycles.
+// Bank rows are padded to whole words; taps past the row end are masked.
+//
+// Overlap: a neuron group's activation and store run behind the next
+// group's S_LOAD_B/S_COMPUTE, so per group only the bias fetch and cur_words
+// MAC cycles are on the critical path; the MAC drain, activation and store
+// are paid once per layer (S_ACTIVATE waits for the last group).
+//
+// Classification: nn_argmax reduces the output layer to its class, score
+// and top-2 margin as it is stored (first maximum wins), so they are valid
+// together with done and ride on m_axis_tuser during S_OUTPUT. With
+// class_only set the result stream is skipped and the core goes straight to
+// S_DONE after the last layer. raw_out skips the output layer's activation,
+// so score and margin are taken before the sigmoid flattens them.
+//==============================================================================
+
+module nn_accelerator_core
+    import nn_pkg::*;
+#(
+    parameter int AXIS_DATA_WIDTH = 32
+)(
+    input  logic    clk,
+    input  logic    rst_n,
+
+    //--------------------------------------------------------------------------
+    // Control / Status
+    //--------------------------------------------------------------------------
+    input  logic    enable,         // Core enable
+    input  logic    start,          // Start inference (pulse)
+    input  logic    stream,         // Start on input data, rearm after done
+    input  logic    continuous,     // Rearm after done, start on START
+    input  logic    load_model,     // Qualifies start: receive a model
+    input  logic    class_only,     // Skip the result stream, class only
+    input  logic    raw_out,        // Output layer without activation
+    output logic    busy,           // Inference in progress
+    output logic    done,           // Inference complete (sticky)
+    output state_t  state,          // Current FSM state
+    output logic [3:0] predicted,   // Argmax of the output layer
+    output fixed_t  score,          // Output value of the predicted class
+    output logic [15:0] margin,     // score minus the runner-up
+    output logic    in_ready,       // An input bank is free for s_axis
+
+    //--------------------------------------------------------------------------
+    // Network Topology
+    //--------------------------------------------------------------------------
+    input  logic [15:0] num_in,
+    input  logic [15:0] num_h1,
+    input  logic [15:0] num_h2,
+    input  logic [15:0] num_out,
+    input  logic [15:0] num_w,      // Weight beats in a model load
+
+    //--------------------------------------------------------------------------
+    // AXI4-Stream Slave (input vector)
+    //--------------------------------------------------------------------------
+    input  logic [AXIS_DATA_WIDTH-1:0] s_axis_tdata,
+    input  logic                       s_axis_tvalid,
+    output logic                       s_axis_tready,
+    input  logic                       s_axis_tlast,
+
+    //--------------------------------------------------------------------------
+    // AXI4-Stream Master (output vector)
+    //--------------------------------------------------------------------------
+    output logic [AXIS_DATA_WIDTH-1:0] m_axis_tdata,
+    output logic                       m_axis_tvalid,
+    input  logic                       m_axis_tready,
+    output logic                       m_axis_tlast,
+    output logic [RESULT_TUSER_WIDTH-1:0] m_axis_tuser  // {class, margin, score}
+);
+
+    //--------------------------------------------------------------------------
+    // Parameters
+    //--------------------------------------------------------------------------
+    localparam int NUM_LAYERS = MAX_LAYERS - 1;     // Weight layers
+    localparam int LANE_W     = $clog2(NUM_PARALLEL);
+    localparam int TAP_W      = $clog2(IN_PARALLEL + 1);
+    localparam int IN_WORDS   = (MAX_LAYER_SIZE + IN_PARALLEL - 1) / IN_PARALLEL;
+    // Bank share of the weights plus room for each layer's partial group
+    // and each row's partial word
+    localparam int W_BANK_DEPTH = WEIGHT_MEM_DEPTH / (NUM_PARALLEL * IN_PARALLEL) +
+                                  2 * IN_WORDS + BIAS_MEM_DEPTH / NUM_PARALLEL;
+    localparam int W_ADDR_W   = $clog2(W_BANK_DEPTH);
+    localparam int B_ADDR_W   = $clog2(BIAS_MEM_DEPTH);
+    localparam int A_ADDR_W   = $clog2(IN_WORDS);
+    localparam int I_ADDR_W   = $clog2(2 * IN_WORDS);
+
+    //--------------------------------------------------------------------------
+    // Memories
+    //   g_lane[l].bank: rows of neurons n % NUM_PARALLEL == l, layer-major,
+    //                   one group of ceil(cur_in / IN_PARALLEL) words per
+    //                   neuron group
+    //   bias_mem:   layer-major, one bias per neuron
+    //   in_mem:     two input banks of IN_WORDS (layer 0 reads one)
+    //   nz_list:    per input bank, indices of its nonzero words
+    //   act_mem_a/b: ping-pong activation buffers (layer 0 writes B)
+    // Value i of a vector is tap i % IN_PARALLEL of word i / IN_PARALLEL;
+    // single values are written with per-tap write enables.
+    //--------------------------------------------------------------------------
+    fixed_t bias_mem   [0:BIAS_MEM_DEPTH-1];
+
+    (* ram_style = "block" *)
+    fixed_vec_t in_mem    [0:2*IN_WORDS-1];
+    (* ram_style = "distributed" *)
+    logic [A_ADDR_W-1:0] nz_list [0:2*IN_WORDS-1];
+    (* ram_style = "block" *)
+    fixed_vec_t act_mem_a [0:IN_WORDS-1];
+    (* ram_style = "block" *)
+    fixed_vec_t act_mem_b [0:IN_WORDS-1];
+
+    initial begin
+        $readmemh("nn_model_biases.mem", bias_mem);
+    end
+
+    if (NUM_PARALLEL < 2 || NUM_PARALLEL > 32 ||
+        (NUM_PARALLEL & (NUM_PARALLEL - 1)) != 0) begin : g_check
+        $error("NUM_PARALLEL must be 2, 4, 8, 16 or 32");
+    end
+
+    if (IN_PARALLEL < 1 || IN_PARALLEL > 8 ||
+        (IN_PARALLEL & (IN_PARALLEL - 1)) != 0) begin : g_check_in
+        $error("IN_PARALLEL must be 1, 2, 4 or 8");
+    end
+
+    //--------------------------------------------------------------------------
+    // Internal Signals
+    //--------------------------------------------------------------------------
+    // Latched topology
+    logic [15:0]            cfg_size [0:MAX_LAYERS-1];
+    logic [15:0]            cur_in, cur_out;
+    logic [15:0]            cur_words;      // Bank words per row of this layer
+    logic [15:0]            num_out_q;
+
+    // Sequencing
+    logic [1:0]             layer;
+    logic [15:0]            in_cnt;         // Beats in the bank being filled
+    logic [15:0]            n_base;         // First neuron of current group
+    logic [15:0]            idx;            // Input word being issued
+    logic [15:0]            cur_iters;      // Words issued per group
+    logic [15:0]            rd_word;        // Input word read for idx
+    logic [$clog2(NUM_PARALLEL+1)-1:0] store_lane;
+    logic [15:0]            out_idx;
+    logic                   out_pending;    // Output read issued, data next cycle
+
+    // Result store (runs while the following groups compute)
+    fixed_t                 st_val [0:NUM_PARALLEL-1];
+    logic [15:0]            st_base;        // First neuron of the group to store
+    logic                   st_busy;
+    logic                   st_pend;        // Finished group waiting in neuron_out
+
+    // Output layer argmax
+    logic                   am_valid;
+    logic [15:0]            am_idx;
+
+    // Memory bases for the current layer / group
+    logic [W_ADDR_W-1:0]    w_grp_base;     // Bank address of the group's rows
+    logic [B_ADDR_W-1:0]    b_layer_base;
+
+    // Input banks
+    logic [1:0]             in_full;        // Bank holds a complete frame
+    logic                   in_wr_bank;     // Bank s_axis fills
+    logic                   in_rd_bank;     // Bank layer 0 reads
+    logic                   in_fill;        // s_axis beats go to in_wr_bank
+    logic                   in_we;
+    logic [I_ADDR_W-1:0]    in_wr_addr;
+    logic [TAP_W-1:0]       in_wr_tap;
+    fixed_t                 in_wr_data;
+    fixed_vec_t             in_rd;
+    logic                   src_in_d;       // Operand read from the input bank
+    logic                   l0_stream;      // Group 0 takes pixels from s_axis
+    logic                   l0_arm;         // This cycle arms l0_stream
+    fixed_vec_t             px_q;           // Pixels of the word being accepted
+    logic                   src_px_d;       // Operand is px_q
+    logic                   in_last;        // Beat ends the frame
+    logic                   in_word_end;    // Beat ends an input word
+
+    // Zero skipping
+    logic                   l0_skip;        // Layer 0 walks nz_list
+    logic                   px_nz;          // Word being filled has a nonzero pixel
+    logic                   px_word_nz;     // ...including this beat
+    logic                   nz_add;         // Beat completes a nonzero word
+    logic [15:0]            nz_fill;        // Nonzero words in the frame so far
+    logic [15:0]            nz_cnt [0:1];   // Nonzero words per full bank
+
+    // Activation memory ports
+    logic [A_ADDR_W-1:0]    act_rd_addr;
+    fixed_vec_t             act_rd_a, act_rd_b;
+    fixed_vec_t             act_rd;
+    logic                   act_src_b;      // Current layer reads buffer B
+    logic                   act_src_b_d;
+    logic [A_ADDR_W-1:0]    act_wr_addr;
+    logic [TAP_W-1:0]       act_wr_tap;
+    fixed_t                 act_wr_data;
+    logic                   act_we_a, act_we_b;
+
+    // Weight banks: one shared read address, one read port per lane
+    logic [W_ADDR_W-1:0]    w_rd_addr;
+    fixed_vec_t             w_rd_data [0:NUM_PARALLEL-1];
+
+    // Model load write port
+    logic [15:0]            ld_cnt;         // Model beats received
+    logic                   ld_we_w, ld_we_b;
+    logic [15:0]            ld_addr;        // Bias address
+    fixed_t                 ld_data;
+    logic [15:0]            ld_size [0:MAX_LAYERS-1];
+    logic [1:0]             ld_layer;       // Position of the next weight beat
+    logic [15:0]            ld_row;
+    logic [15:0]            ld_col;
+    logic [15:0]            ld_grp_base;    // Bank address of ld_row's group
+    logic [15:0]            ld_words;       // Bank words per row of ld_layer
+    logic [LANE_W-1:0]      ld_lane;
+    logic [W_ADDR_W-1:0]    ld_waddr;
+    logic [TAP_W-1:0]       ld_tap;
+
+    // Neuron interface
+    logic                   rd_valid;       // Operands valid this cycle
+    logic                   rd_last;        // ...and they are the last input
+    logic [IN_PARALLEL-1:0] rd_mask;        // Taps within the row
+    logic                   bias_load;      // Bias load, starts a neuron group
+    fixed_t                 bias_q    [0:NUM_PARALLEL-1];
+    fixed_t                 neuron_in [IN_PARALLEL];
+    logic [NUM_PARALLEL-1:0] neuron_done;
+    fixed_t                 neuron_out [0:NUM_PARALLEL-1];
+
+    // Sigmoid LUT interface
+    logic [SIGMOID_ADDR_WIDTH-1:0] sig_addr [0:NUM_PARALLEL-1];
+    fixed_t                        sig_data [0:NUM_PARALLEL-1];
+    logic                          sig_en   [0:NUM_PARALLEL-1];
+
+    //--------------------------------------------------------------------------
+    // Layer Geometry
+    //--------------------------------------------------------------------------
+    assign cur_in  = cfg_size[layer];
+    assign cur_out = cfg_size[layer + 1];
+    assign num_out_q = cfg_size[MAX_LAYERS-1];
+    assign cur_words = (cur_in + IN_PARALLEL - 1) / IN_PARALLEL;
+
+    // A blank frame still issues one (fully masked) word per group
+    assign l0_skip   = ZERO_SKIP && layer == 0;
+    assign cur_iters = !l0_skip                 ? cur_words :
+                       (nz_cnt[in_rd_bank] == 0) ? 16'd1    : nz_cnt[in_rd_bank];
+    assign rd_word   = l0_skip ? 16'(nz_list[I_ADDR_W'(in_rd_bank * IN_WORDS) + I_ADDR_W'(idx)]) :
+                                 idx;
+
+    assign ld_size  = '{num_in, num_h1, num_h2, num_out};
+    assign ld_words = (ld_size[ld_layer] + IN_PARALLEL - 1) / IN_PARALLEL;
+
+    //--------------------------------------------------------------------------
+    // Weight Bank Read Address (the same row offset in every bank)
+    //--------------------------------------------------------------------------
+    assign w_rd_addr = w_grp_base + W_ADDR_W'(l0_stream ? in_cnt / IN_PARALLEL : rd_word);
+
+    always_ff @(posedge clk) begin
+        if (ld_we_b)
+            bias_mem[B_ADDR_W'(ld_addr)] <= ld_data;
+    end
+
+    //--------------------------------------------------------------------------
+    // Activation Memories
+    // Read address follows the input word while computing and the output
+    // index while streaming results; data is available one cycle later.
+    //--------------------------------------------------------------------------
+    assign act_rd_addr = (state == S_OUTPUT) ? A_ADDR_W'(out_idx / IN_PARALLEL) :
+                                               A_ADDR_W'(idx);
+
+    always_ff @(posedge clk) begin
+        for (int t = 0; t < IN_PARALLEL; t++)
+            if (act_we_a && act_wr_tap == TAP_W'(t))
+                act_mem_a[act_wr_addr][t*DATA_WIDTH +: DATA_WIDTH] <= act_wr_data;
+        act_rd_a <= act_mem_a[act_rd_addr];
+    end
+
+    always_ff @(posedge clk) begin
+        for (int t = 0; t < IN_PARALLEL; t++)
+            if (act_we_b && act_wr_tap == TAP_W'(t))
+                act_mem_b[act_wr_addr][t*DATA_WIDTH +: DATA_WIDTH] <= act_wr_data;
+        act_rd_b <= act_mem_b[act_rd_addr];
+    end
+
+    assign act_rd = act_src_b_d ? act_rd_b : act_rd_a;
+
+    //--------------------------------------------------------------------------
+    // Input Banks
+    //--------------------------------------------------------------------------
+    always_ff @(posedge clk) begin
+        for (int t = 0; t < IN_PARALLEL; t++)
+            if (in_we && in_wr_tap == TAP_W'(t))
+                in_mem[in_wr_addr][t*DATA_WIDTH +: DATA_WIDTH] <= in_wr_data;
+        in_rd <= in_mem[I_ADDR_W'(in_rd_bank * IN_WORDS) + I_ADDR_W'(rd_word)];
+    end
+
+    // Nonzero word list, written as each word of the frame completes
+    assign in_last     = s_axis_tlast || in_cnt == num_in - 1;
+    assign in_word_end = in_cnt % IN_PARALLEL == IN_PARALLEL - 1 || in_last;
+    assign px_word_nz  = px_nz || s_axis_tdata[DATA_WIDTH-1:0] != '0;
+    assign nz_add      = in_word_end && px_word_nz && in_cnt < MAX_LAYER_SIZE;
+
+    always_ff @(posedge clk) begin
+        if (in_fill && s_axis_tvalid && nz_add)
+            nz_list[I_ADDR_W'(in_wr_bank * IN_WORDS) + I_ADDR_W'(nz_fill)] <=
+                A_ADDR_W'(in_cnt / IN_PARALLEL);
+    end
+
+    // Streaming layer 0 can start if no pixel of the frame is in yet; the
+    // fill pauses for the cycle that loads the biases
+    assign l0_arm = STREAM_LAYER0 && state == S_LOAD_IN && !l0_stream &&
+                    !in_full[in_rd_bank] && in_wr_bank == in_rd_bank &&
+                    in_cnt == 0;
+
+    // Model upload beats belong to S_LOAD_W, never to an input bank
+    assign in_fill  = enable && !in_full[in_wr_bank] &&
+                      state != S_LOAD_W && !load_model && !l0_arm;
+    assign in_ready = !in_full[in_wr_bank];
+
+    // Taps past the end of the row read padding or stale data: force zero
+    for (genvar t = 0; t < IN_PARALLEL; t++) begin : g_tap
+        assign neuron_in[t] = !rd_mask[t] ? '0 :
+                              src_px_d    ? px_q[t*DATA_WIDTH +: DATA_WIDTH]  :
+                              src_in_d    ? in_rd[t*DATA_WIDTH +: DATA_WIDTH] :
+                                            act_rd[t*DATA_WIDTH +: DATA_WIDTH];
+    end
+
+    //--------------------------------------------------------------------------
+    // Neuron Lanes: weight bank + neuron
+    //--------------------------------------------------------------------------
+    for (genvar l = 0; l < NUM_PARALLEL; l++) begin : g_lane
+        (* ram_style = "block" *)
+        fixed_vec_t bank [0:W_BANK_DEPTH-1];
+        fixed_t     w_tap [IN_PARALLEL];
+
+        // Bitstream model: this lane's rows, already in bank word layout
+        initial begin
+            $readmemh($sformatf("nn_model_weights_lane%0d.mem", l), bank);
+        end
+
+        always_ff @(posedge clk) begin
+            for (int t = 0; t < IN_PARALLEL; t++)
+                if (ld_we_w && ld_lane == LANE_W'(l) && ld_tap == TAP_W'(t))
+                    bank[ld_waddr][t*DATA_WIDTH +: DATA_WIDTH] <= ld_data;
+            w_rd_data[l] <= bank[w_rd_addr];
+        end
+
+        for (genvar t = 0; t < IN_PARALLEL; t++) begin : g_w_tap
+            assign w_tap[t] = rd_mask[t] ? w_rd_data[l][t*DATA_WIDTH +: DATA_WIDTH] : '0;
+        end
+
+        nn_neuron #(
+            .TAPS           (IN_PARALLEL)
+        ) u_neuron (
+            .clk            (clk),
+            .rst_n          (rst_n),
+            .clear          (1'b0),
+            .done           (neuron_done[l]),
+            .busy           (),
+            .input_val      (neuron_in),
+            .weight_val     (w_tap),
+            .bias_val       (bias_q[l]),
+            .load_bias      (bias_load),
+            .mac_enable     (rd_valid),
+            .mac_last       (rd_last),
+            .use_activation (!(raw_out && layer == NUM_LAYERS - 1)),
+            .sigmoid_addr   (sig_addr[l]),
+            .sigmoid_data   (sig_data[l]),
+            .sigmoid_en     (sig_en[l]),
+            .output_val     (neuron_out[l]),
+            .output_valid   ()
+        );
+    end
+
+    //--------------------------------------------------------------------------
+    // Sigmoid LUTs (one dual-port ROM per lane pair; with the other
+    // activations the neurons compute the function themselves)
+    //--------------------------------------------------------------------------
+    for (genvar p = 0; p < NUM_PARALLEL / 2; p++) begin : g_sigmoid
+        if (ACTIVATION == ACT_SIGMOID_LUT) begin : g_rom
+            sigmoid_lut u_sigmoid (
+                .clk    (clk),
+                .rst_n  (rst_n),
+                .addr_a (sig_addr[2*p]),
+                .en_a   (sig_en[2*p]),
+                .data_a (sig_data[2*p]),
+                .addr_b (sig_addr[2*p+1]),
+                .en_b   (sig_en[2*p+1]),
+                .data_b (sig_data[2*p+1])
+            );
+        end
+        else begin : g_none
+            assign sig_data[2*p]   = '0;
+            assign sig_data[2*p+1] = '0;
+        end
+    end
+
+    //--------------------------------------------------------------------------
+    // Output Layer Argmax (fed by the result store, one lane per cycle)
+    //--------------------------------------------------------------------------
+    assign am_idx   = st_base + store_lane;
+    assign am_valid = st_busy && (am_idx < cur_out) && (layer == NUM_LAYERS - 1);
+
+    nn_argmax u_argmax (
+        .clk        (clk),
+        .rst_n      (rst_n),
+        .valid      (am_valid),
+        .idx        (am_idx),
+        .value      (st_val[store_lane]),
+        .best_idx   (predicted),
+        .best_val   (score),
+        .margin     (margin)
+    );
+
+    //--------------------------------------------------------------------------
+    // Stream Interfaces
+    //--------------------------------------------------------------------------
+    assign s_axis_tready = (enable && state == S_LOAD_W) || in_fill;
+
+    assign m_axis_tdata  = AXIS_DATA_WIDTH'($signed(
+                               act_rd[(out_idx % IN_PARALLEL)*DATA_WIDTH +: DATA_WIDTH]));
+    assign m_axis_tvalid = (state == S_OUTPUT) && out_pending;
+    assign m_axis_tlast  = m_axis_tvalid && (out_idx == num_out_q - 1);
+    assign m_axis_tuser  = {predicted, margin, score};
+
+    assign busy = (state != S_IDLE) && (state != S_DONE);
+
+    //--------------------------------------------------------------------------
+    // Main State Machine
+    //--------------------------------------------------------------------------
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            state        <= S_IDLE;
+            done         <= 1'b0;
+            layer        <= '0;
+            in_cnt       <= '0;
+            ld_cnt       <= '0;
+            ld_we_w      <= 1'b0;
+            ld_we_b      <= 1'b0;
+            ld_addr      <= '0;
+            ld_data      <= '0;
+            ld_layer     <= '0;
+            ld_row       <= '0;
+            ld_col       <= '0;
+            ld_grp_base  <= '0;
+            ld_lane      <= '0;
+            ld_waddr     <= '0;
+            ld_tap       <= '0;
+            n_base       <= '0;
+            idx          <= '0;
+            store_lane   <= '0;
+            st_base      <= '0;
+            st_busy      <= 1'b0;
+            st_pend      <= 1'b0;
+            out_idx      <= '0;
+            out_pending  <= 1'b0;
+            w_grp_base   <= '0;
+            b_layer_base <= '0;
+            act_src_b    <= 1'b0;
+            act_src_b_d  <= 1'b0;
+            src_in_d     <= 1'b0;
+            src_px_d     <= 1'b0;
+            l0_stream    <= 1'b0;
+            px_q         <= '0;
+            px_nz        <= 1'b0;
+            nz_fill      <= '0;
+            nz_cnt       <= '{default: '0};
+            in_full      <= 2'b00;
+            in_wr_bank   <= 1'b0;
+            in_rd_bank   <= 1'b0;
+            in_we        <= 1'b0;
+            in_wr_addr   <= '0;
+            in_wr_tap    <= '0;
+            in_wr_data   <= '0;
+            act_wr_addr  <= '0;
+            act_wr_tap   <= '0;
+            act_wr_data  <= '0;
+            act_we_a     <= 1'b0;
+            act_we_b     <= 1'b0;
+            rd_valid     <= 1'b0;
+            rd_last      <= 1'b0;
+            rd_mask      <= '0;
+            bias_load    <= 1'b0;
+            for (int l = 0; l < NUM_PARALLEL; l++) begin
+                bias_q[l] <= '0;
+                st_val[l] <= '0;
+            end
+            for (int i = 0; i < MAX_LAYERS; i++)
+                cfg_size[i] <= '0;
+        end
+        else begin
+            // Default values
+            act_we_a    <= 1'b0;
+            act_we_b    <= 1'b0;
+            ld_we_w     <= 1'b0;
+            ld_we_b     <= 1'b0;
+            rd_valid    <= 1'b0;
+            rd_last     <= 1'b0;
+            bias_load   <= 1'b0;
+            act_src_b_d <= act_src_b;
+            src_in_d    <= (layer == 0);
+            src_px_d    <= l0_stream;
+            in_we       <= 1'b0;
+
+            if (enable) begin
+                case (state)
+                    //----------------------------------------------------------
+                    S_IDLE: begin
+                        if (start && load_model) begin
+                            ld_cnt      <= '0;
+                            ld_layer    <= '0;
+                            ld_row      <= '0;
+                            ld_col      <= '0;
+                            ld_grp_base <= '0;
+                            state       <= S_LOAD_W;
+                        end
+                        else if (start || (stream && in_full[in_rd_bank])) begin
+                            done  <= 1'b0;
+                            state <= S_LOAD_CFG;
+                        end
+                    end
+
+                    //----------------------------------------------------------
+                    S_LOAD_W: begin
+                        // Model upload: weights, then biases, until TLAST
+                        if (s_axis_tvalid) begin
+                            ld_data <= fixed_t'(s_axis_tdata[DATA_WIDTH-1:0]);
+                            ld_cnt  <= ld_cnt + 1;
+                            if (ld_cnt < num_w) begin
+                                // Row n of each layer goes to bank n % NUM_PARALLEL
+                                ld_lane  <= ld_row[LANE_W-1:0];
+                                ld_waddr <= W_ADDR_W'(ld_grp_base + ld_col / IN_PARALLEL);
+                                ld_tap   <= TAP_W'(ld_col % IN_PARALLEL);
+                                ld_we_w  <= (ld_layer < NUM_LAYERS) &&
+                                            (ld_grp_base + ld_col / IN_PARALLEL < W_BANK_DEPTH);
+
+                                if (ld_col == ld_size[ld_layer] - 1) begin
+                                    ld_col <= '0;
+                                    if (ld_row == ld_size[ld_layer + 1] - 1) begin
+                                        ld_row      <= '0;
+                                        ld_layer    <= ld_layer + 1;
+                                        ld_grp_base <= ld_grp_base + ld_words;
+                                    end
+                                    else begin
+                                        ld_row <= ld_row + 1;
+                                        if (ld_row[LANE_W-1:0] == LANE_W'(NUM_PARALLEL - 1))
+                                            ld_grp_base <= ld_grp_base + ld_words;
+                                    end
+                                end
+                                else begin
+                                    ld_col <= ld_col + 1;
+                                end
+                            end
+                            else begin
+                                ld_addr <= ld_cnt - num_w;
+                                ld_we_b <= (ld_cnt - num_w < BIAS_MEM_DEPTH);
+                            end
+
+                            if (s_axis_tlast)
+                                state <= S_IDLE;
+                        end
+                    end
+
+                    //----------------------------------------------------------
+                    S_LOAD_CFG: begin
+                        cfg_size[0]  <= num_in;
+                        cfg_size[1]  <= num_h1;
+                        cfg_size[2]  <= num_h2;
+                        cfg_size[3]  <= num_out;
+                        layer        <= '0;
+                        w_grp_base   <= '0;
+                        b_layer_base <= '0;
+                        state        <= S_LOAD_IN;
+                    end
+
+                    //----------------------------------------------------------
+                    S_LOAD_IN: begin
+                        if (l0_stream) begin
+                            // Last pixel issued: group 0 is done
+                            if (in_full[in_rd_bank]) begin
+                                l0_stream <= 1'b0;
+                                if (NUM_PARALLEL >= cur_out) begin
+                                    state <= S_ACTIVATE;
+                                end
+                                else begin
+                                    n_base     <= NUM_PARALLEL;
+                                    w_grp_base <= w_grp_base + W_ADDR_W'(cur_words);
+                                    state      <= S_LOAD_B;
+                                end
+                            end
+                        end
+                        else if (l0_arm) begin
+                            // Group 0 biases now, pixels from the next cycle
+                            for (int l = 0; l < NUM_PARALLEL; l++)
+                                bias_q[l] <= bias_mem[B_ADDR_W'(l)];
+                            bias_load <= 1'b1;
+                            n_base    <= '0;
+                            st_base   <= '0;
+                            act_src_b <= 1'b0;
+                            l0_stream <= 1'b1;
+                        end
+                        else if (in_full[in_rd_bank]) begin
+                            // Frame already in (prefetched): compute from the bank
+                            n_base    <= '0;
+                            st_base   <= '0;
+                            act_src_b <= 1'b0;
+                            state     <= S_LOAD_B;
+                        end
+                    end
+
+                    //----------------------------------------------------------
+                    S_LOAD_B: begin
+                        // Fetch biases for this neuron group. At most two
+                        // groups may be unstored: one in the store process,
+                        // one waiting in the neuron outputs.
+                        if (n_base - st_base < 16'(2 * NUM_PARALLEL)) begin
+                            for (int l = 0; l < NUM_PARALLEL; l++)
+                                bias_q[l] <= bias_mem[b_layer_base + B_ADDR_W'(n_base) + B_ADDR_W'(l)];
+                            bias_load <= 1'b1;
+                            idx       <= '0;
+                            state     <= S_COMPUTE;
+                        end
+                    end
+
+                    //----------------------------------------------------------
+                    S_COMPUTE: begin
+                        // Issue one input/weight word read per cycle; the
+                        // neurons accumulate it one cycle later (rd_valid)
+                        rd_valid <= 1'b1;
+                        rd_last  <= (idx == cur_iters - 1);
+                        for (int t = 0; t < IN_PARALLEL; t++)
+                            rd_mask[t] <= (rd_word * IN_PARALLEL + t < cur_in) &&
+                                          !(l0_skip && nz_cnt[in_rd_bank] == 0);
+
+                        // The next group starts while this one drains
+                        if (idx == cur_iters - 1) begin
+                            if (n_base + NUM_PARALLEL >= cur_out) begin
+                                state <= S_ACTIVATE;
+                            end
+                            else begin
+                                n_base     <= n_base + NUM_PARALLEL;
+                                w_grp_base <= w_grp_base + W_ADDR_W'(cur_words);
+                                state      <= S_LOAD_B;
+                            end
+                        end
+                        else begin
+                            idx <= idx + 1;
+                        end
+                    end
+
+                    //----------------------------------------------------------
+                    S_ACTIVATE: begin
+                        // Wait until the last group is activated and stored
+                        if (st_base > n_base) begin
+                            state <= S_NEXT_LAYER;
+                        end
+                    end
+
+                    //----------------------------------------------------------
+                    S_NEXT_LAYER: begin
+                        if (layer == NUM_LAYERS - 1) begin
+                            // Results are in the buffer this layer wrote
+                            act_src_b   <= !act_src_b;
+                            out_idx     <= '0;
+                            out_pending <= 1'b0;
+                            state       <= class_only ? S_DONE : S_OUTPUT;
+                        end
+                        else begin
+                            // Layer 0 is done with the input: free its bank
+                            if (layer == 0) begin
+                                in_full[in_rd_bank] <= 1'b0;
+                                in_rd_bank          <= !in_rd_bank;
+                            end
+                            w_grp_base   <= w_grp_base + W_ADDR_W'(cur_words);
+                            b_layer_base <= b_layer_base + B_ADDR_W'(cur_out);
+                            layer        <= layer + 1;
+                            n_base       <= '0;
+                            st_base      <= '0;
+                            act_src_b    <= !act_src_b;
+                            state        <= S_LOAD_B;
+                        end
+                    end
+
+                    //----------------------------------------------------------
+                    S_OUTPUT: begin
+                        // Read one result, hold it on m_axis until accepted
+                        if (!out_pending) begin
+                            out_pending <= 1'b1;
+                        end
+                        else if (m_axis_tready) begin
+                            out_pending <= 1'b0;
+                            if (out_idx == num_out_q - 1) begin
+                                state <= S_DONE;
+                            end
+                            else begin
+                                out_idx <= out_idx + 1;
+                            end
+                        end
+                    end
+
+                    //----------------------------------------------------------
+                    S_DONE: begin
+                        // Hold results until soft reset, or rearm for the
+                        // next frame in stream / continuous mode
+                        done <= 1'b1;
+                        if (continuous && start && load_model) begin
+                            ld_cnt      <= '0;
+                            ld_layer    <= '0;
+                            ld_row      <= '0;
+                            ld_col      <= '0;
+                            ld_grp_base <= '0;
+                            state       <= S_LOAD_W;
+                        end
+                        else if (continuous && start) begin
+                            done  <= 1'b0;
+                            state <= S_LOAD_CFG;
+                        end
+                        else if (stream || continuous) begin
+                            state <= S_IDLE;
+                        end
+                    end
+
+                    //----------------------------------------------------------
+                    default: state <= S_IDLE;
+                endcase
+
+                //--------------------------------------------------------------
+                // Input Fill: s_axis into the free bank, one beat per cycle
+                //--------------------------------------------------------------
+                if (in_fill && s_axis_tvalid) begin
+                    in_wr_addr <= I_ADDR_W'(in_wr_bank * IN_WORDS) + I_ADDR_W'(in_cnt / IN_PARALLEL);
+                    in_wr_tap  <= TAP_W'(in_cnt % IN_PARALLEL);
+                    in_wr_data <= fixed_t'(s_axis_tdata[DATA_WIDTH-1:0]);
+                    in_we      <= (in_cnt < MAX_LAYER_SIZE);
+                    in_cnt     <= in_cnt + 1;
+
+                    // Broadcast to group 0 once a word is complete (its
+                    // weights are read at in_cnt / IN_PARALLEL this cycle)
+                    px_q[(in_cnt % IN_PARALLEL)*DATA_WIDTH +: DATA_WIDTH] <=
+                        s_axis_tdata[DATA_WIDTH-1:0];
+                    if (l0_stream && in_word_end) begin
+                        rd_valid <= 1'b1;
+                        rd_last  <= in_last;
+                        for (int t = 0; t < IN_PARALLEL; t++)
+                            rd_mask[t] <= (t <= in_cnt % IN_PARALLEL);
+                    end
+
+                    // Count the nonzero words (nz_list is written above)
+                    px_nz <= in_word_end ? 1'b0 : px_word_nz;
+                    if (nz_add)
+                        nz_fill <= nz_fill + 1;
+
+                    if (in_last) begin
+                        in_full[in_wr_bank] <= 1'b1;
+                        in_wr_bank          <= !in_wr_bank;
+                        in_cnt              <= '0;
+                        nz_cnt[in_wr_bank]  <= nz_fill + 16'(nz_add);
+                        nz_fill             <= '0;
+                    end
+                end
+
+                //--------------------------------------------------------------
+                // Result Store: take a finished group from the neurons and
+                // write one lane per cycle into the other buffer
+                //--------------------------------------------------------------
+                if (st_busy) begin
+                    if (st_base + store_lane < cur_out) begin
+                        act_wr_addr <= A_ADDR_W'((st_base + store_lane) / IN_PARALLEL);
+                        act_wr_tap  <= TAP_W'((st_base + store_lane) % IN_PARALLEL);
+                        act_wr_data <= st_val[store_lane];
+                        act_we_a    <= act_src_b;
+                        act_we_b    <= !act_src_b;
+                    end
+
+                    if (store_lane == NUM_PARALLEL - 1) begin
+                        st_busy <= 1'b0;
+                        st_base <= st_base + NUM_PARALLEL;
+                    end
+                    else begin
+                        store_lane <= store_lane + 1;
+                    end
+
+                    if (neuron_done[0])
+                        st_pend <= 1'b1;
+                end
+                else if (neuron_done[0] || st_pend) begin
+                    for (int l = 0; l < NUM_PARALLEL; l++)
+                        st_val[l] <= neuron_out[l];
+                    store_lane <= '0;
+                    st_busy    <= 1'b1;
+                    st_pend    <= 1'b0;
+                end
+            end
+        end
+    end
+
+endmodule
@@ -0,0 +1,101 @@
+//==============================================================================
+// File: nn_activation.sv
+// Description: Per-lane activation unit without block RAM
+//
+// ACTIVATION (nn_pkg) selects the function of x (S.4.11):
+//   ACT_SIGMOID_INTERP: sigmoid from SIGMOID_INTERP_SEGS linear segments
+//                       over [-8, +8) (sigmoid_interp.mem), end values
+//                       outside
+//   ACT_HARD_SIGMOID:   clamp((x >>> 2) + 0.5, 0, 1)
+//   ACT_RELU:           max(x, 0)
+//
+// One result per cycle, registered like a ROM read. NN_Activate() in the
+// driver and fixed_activation() in network.py compute the same values.
+//==============================================================================
+
+module nn_activation
+    import nn_pkg::*;
+(
+    input  logic    clk,
+    input  fixed_t  x,              // Pre-activation
+    input  logic    en,             // Register y
+    output fixed_t  y               // Activation, one cycle after en
+);
+
+    //--------------------------------------------------------------------------
+    // Parameters
+    // u = x + 8.0 splits into a segment index (top SEG_W bits of the 16.0
+    // range) and the position within the segment (FRAC_W bits)
+    //--------------------------------------------------------------------------
+    localparam int SEG_W  = $clog2(SIGMOID_INTERP_SEGS);
+    localparam int FRAC_W = FRAC_BITS + 4 - SEG_W;
+
+    //--------------------------------------------------------------------------
+    // Segment End Points (SIGMOID_INTERP_SEGS + 1 entries, LUT ROM)
+    //--------------------------------------------------------------------------
+    (* rom_style = "distributed" *)
+    fixed_t seg_rom [0:SIGMOID_INTERP_SEGS];
+
+    initial begin
+        if (ACTIVATION == ACT_SIGMOID_INTERP)
+            $readmemh("sigmoid_interp.mem", seg_rom);
+    end
+
+    //--------------------------------------------------------------------------
+    // Internal Signals
+    //--------------------------------------------------------------------------
+    logic signed [DATA_WIDTH:0] u;
+    logic [SEG_W:0]             seg;
+    logic [FRAC_W-1:0]          frac;
+    fixed_t                     y0, y1;
+    logic signed [31:0]         step;
+    logic signed [DATA_WIDTH:0] hard;
+    fixed_t                     y_next;
+
+    assign u    = x + (17'sd8 <<< FRAC_BITS);
+    assign seg  = {1'b0, u[FRAC_BITS+3 -: SEG_W]};
+    assign frac = u[FRAC_W-1:0];
+    assign y0   = seg_rom[seg];
+    assign y1   = seg_rom[seg + 1];
+    assign step = ((32'(y1) - 32'(y0)) * $signed({1'b0, frac})) >>> FRAC_W;
+    assign hard = (x >>> 2) + (17'sd1 <<< (FRAC_BITS - 1));
+
+    //--------------------------------------------------------------------------
+    // Function Select
+    //--------------------------------------------------------------------------
+    always_comb begin
+        case (ACTIVATION)
+            ACT_HARD_SIGMOID: begin
+                if (hard < 0)
+                    y_next = '0;
+                else if (hard > (17'sd1 <<< FRAC_BITS))
+                    y_next = 16'sd1 <<< FRAC_BITS;
+                else
+                    y_next = fixed_t'(hard);
+            end
+
+            ACT_RELU: begin
+                y_next = x[DATA_WIDTH-1] ? '0 : x;
+            end
+
+            default: begin
+                // ACT_SIGMOID_INTERP
+                if (u < 0)
+                    y_next = seg_rom[0];
+                else if (u >= (17'sd16 <<< FRAC_BITS))
+                    y_next = seg_rom[SIGMOID_INTERP_SEGS];
+                else
+                    y_next = y0 + fixed_t'(step);
+            end
+        endcase
+    end
+
+    //--------------------------------------------------------------------------
+    // Output Register
+    //--------------------------------------------------------------------------
+    always_ff @(posedge clk) begin
+        if (en)
+            y <= y_next;
+    end
+
+endmodule
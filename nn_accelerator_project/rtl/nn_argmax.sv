@@ -0,0 +1,67 @@
+//==============================================================================
+// File: nn_argmax.sv
+// Description: Streaming top-2 comparator for the output layer
+//
+// Takes the output layer one value at a time, in any order, as it is
+// stored. idx == 0 starts a new vector. Keeps the largest value (first
+// maximum wins), its index, and the runner-up, so that after the last
+// value:
+//   best_idx: predicted class
+//   best_val: its score (S.4.11, raw or after activation)
+//   margin:   best_val - runner-up (0 on a tie, 65535 with one output)
+//
+// Results are registered and valid the cycle after the last value.
+//==============================================================================
+
+module nn_argmax
+    import nn_pkg::*;
+(
+    input  logic        clk,
+    input  logic        rst_n,
+
+    input  logic        valid,          // value/idx belong to the vector
+    input  logic [15:0] idx,            // Output index, 0 restarts
+    input  fixed_t      value,
+
+    output logic [3:0]  best_idx,
+    output fixed_t      best_val,
+    output logic [15:0] margin
+);
+
+    //--------------------------------------------------------------------------
+    // Internal Signals
+    //--------------------------------------------------------------------------
+    fixed_t                     second_val;
+    logic signed [DATA_WIDTH:0] diff;
+
+    // best_val >= second_val, so the difference fits 16 bits unsigned
+    assign diff   = (DATA_WIDTH+1)'(best_val) - (DATA_WIDTH+1)'(second_val);
+    assign margin = diff[15:0];
+
+    //--------------------------------------------------------------------------
+    // Compare and Update
+    //--------------------------------------------------------------------------
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            best_idx   <= '0;
+            best_val   <= '0;
+            second_val <= '0;
+        end
+        else if (valid) begin
+            if (idx == 0) begin
+                best_idx   <= '0;
+                best_val   <= value;
+                second_val <= -16'sd32768;
+            end
+            else if (value > best_val) begin
+                best_idx   <= 4'(idx);
+                best_val   <= value;
+                second_val <= best_val;
+            end
+            else if (value > second_val) begin
+                second_val <= value;
+            end
+        end
+    end
+
+endmodule
@@ -0,0 +1,505 @@
+//==============================================================================
+// File: nn_dataflow_core.sv
+// Description: Layer-pipelined MLP compute core (nn_pkg::DATAFLOW = 1)
+//
+// Drop-in alternative to nn_accelerator_core with the same ports. Each
+// weight layer has its own nn_layer_engine; the engines are chained by
+// double-buffered activation buffers, so while image k is in layers 1-2
+// image k+1 is already in layer 0:
+//
+//   s_axis -> buf0 -> engine0 -> buf1 -> engine1 -> buf2 -> engine2 -> buf3
+//          -> m_axis
+//
+// A buffer half is filled by its writer, then handed to its reader, and
+// is returned once the reader is done. Lanes per engine (DF_L*_PARALLEL)
+// are chosen so that layer 0, whose issue time matches the input stream,
+// sets the frame rate.
+//
+// Modes: frames overlap in stream mode. A START frame runs the same path.
+// Continuous mode needs no rearm here and behaves like START. done drops
+// when a frame is taken on START, or when the result stage begins the
+// next frame, and is set again when that frame is complete; predicted,
+// score and margin follow done and are on m_axis_tuser while the frame's
+// results stream out. raw_out skips engine 2's activation.
+//
+// Topology and model: the NUM_* registers are latched when a frame or a
+// model load starts with the pipeline empty. A model load waits for the
+// pipeline to drain. Hidden and output layers hold at most
+// BIAS_MEM_DEPTH neurons.
+//==============================================================================
+
+module nn_dataflow_core
+    import nn_pkg::*;
+#(
+    parameter int AXIS_DATA_WIDTH = 32
+)(
+    input  logic    clk,
+    input  logic    rst_n,
+
+    //--------------------------------------------------------------------------
+    // Control / Status
+    //--------------------------------------------------------------------------
+    input  logic    enable,         // Core enable
+    input  logic    start,          // Start inference (pulse)
+    input  logic    stream,         // Start on input data
+    input  logic    continuous,     // Same as START here
+    input  logic    load_model,     // Qualifies start: receive a model
+    input  logic    class_only,     // Skip the result stream, class only
+    input  logic    raw_out,        // Output layer without activation
+    output logic    busy,           // Frames in flight
+    output logic    done,           // Frame complete
+    output state_t  state,          // Summary state for STATUS
+    output logic [3:0] predicted,   // Argmax of the last completed frame
+    output fixed_t  score,          // Output value of the predicted class
+    output logic [15:0] margin,     // score minus the runner-up
+    output logic    in_ready,       // A buf0 half is free for s_axis
+
+    //--------------------------------------------------------------------------
+    // Network Topology
+    //--------------------------------------------------------------------------
+    input  logic [15:0] num_in,
+    input  logic [15:0] num_h1,
+    input  logic [15:0] num_h2,
+    input  logic [15:0] num_out,
+    input  logic [15:0] num_w,      // Weight beats in a model load
+
+    //--------------------------------------------------------------------------
+    // AXI4-Stream Slave (input vector)
+    //--------------------------------------------------------------------------
+    input  logic [AXIS_DATA_WIDTH-1:0] s_axis_tdata,
+    input  logic                       s_axis_tvalid,
+    output logic                       s_axis_tready,
+    input  logic                       s_axis_tlast,
+
+    //--------------------------------------------------------------------------
+    // AXI4-Stream Master (output vector)
+    //--------------------------------------------------------------------------
+    output logic [AXIS_DATA_WIDTH-1:0] m_axis_tdata,
+    output logic                       m_axis_tvalid,
+    input  logic                       m_axis_tready,
+    output logic                       m_axis_tlast,
+    output logic [RESULT_TUSER_WIDTH-1:0] m_axis_tuser  // {class, margin, score}
+);
+
+    //--------------------------------------------------------------------------
+    // Parameters
+    //--------------------------------------------------------------------------
+    localparam int NUM_LAYERS = MAX_LAYERS - 1;
+    localparam int NUM_BUFS   = NUM_LAYERS + 1;
+    localparam int HID_SIZE   = BIAS_MEM_DEPTH;     // Largest hidden/output layer
+
+    localparam int ENG_LANES [0:NUM_LAYERS-1] = '{
+        DF_L0_PARALLEL, DF_L1_PARALLEL, DF_L2_PARALLEL
+    };
+    localparam int ENG_WEIGHTS [0:NUM_LAYERS-1] = '{
+        DF_L0_WEIGHTS, DF_L1_WEIGHTS, DF_L2_WEIGHTS
+    };
+
+    typedef enum logic [1:0] { F_IDLE, F_LOAD_IN, F_LOAD_W } fe_state_t;
+    typedef enum logic [1:0] { O_IDLE, O_SEND, O_FINISH } out_state_t;
+
+    //--------------------------------------------------------------------------
+    // Internal Signals
+    //--------------------------------------------------------------------------
+    logic [15:0]            cfg_size [0:MAX_LAYERS-1];
+    logic                   start_q;        // START seen, frame not yet taken
+    logic                   load_q;         // ...and it is a model load
+
+    // Front end: input frames and model loads
+    fe_state_t              fe_state;
+    logic [15:0]            in_cnt;
+    logic                   fe_we;          // buf0 write port
+    logic [15:0]            fe_wr_addr;
+    fixed_t                 fe_wr_data;
+    logic [15:0]            ld_cnt;
+    logic [1:0]             ld_layer;       // Layer of the next weight beat
+    logic [15:0]            ld_row, ld_col;
+    logic [15:0]            ld_bias;        // Bias index of the current beat
+    logic [15:0]            ld_b_addr;
+    logic [NUM_LAYERS-1:0]  ld_we_w, ld_we_b;
+    logic                   ld_start;
+    fixed_t                 ld_data;
+
+    // Activation buffers: two halves each, full[b][h] set by the writer
+    // and cleared by the reader
+    logic [1:0]             buf_full [0:NUM_BUFS-1];
+    logic                   wr_half  [0:NUM_BUFS-1];
+    logic                   rd_half  [0:NUM_BUFS-1];
+    logic                   buf_we       [0:NUM_BUFS-1];
+    logic                   buf_we_half  [0:NUM_BUFS-1];
+    logic [15:0]            buf_wr_addr  [0:NUM_BUFS-1];
+    fixed_t                 buf_wr_data  [0:NUM_BUFS-1];
+    logic                   buf_rd_half  [0:NUM_BUFS-1];
+    logic [15:0]            buf_rd_addr  [0:NUM_BUFS-1];
+    fixed_t                 buf_rd_data  [0:NUM_BUFS-1];
+
+    // Engines
+    logic [NUM_LAYERS-1:0]  eng_start, eng_done, eng_run;
+    logic                   eng_src [0:NUM_LAYERS-1];
+    logic                   eng_dst [0:NUM_LAYERS-1];
+
+    // Output layer argmax, per buf3 half
+    logic [3:0]             best_idx;
+    fixed_t                 best_val;
+    logic [15:0]            best_margin;
+    logic [3:0]             pred_q   [0:1];
+    fixed_t                 score_q  [0:1];
+    logic [15:0]            margin_q [0:1];
+
+    // Result stage
+    out_state_t             o_state;
+    logic [15:0]            out_idx;
+    logic                   out_pending;
+
+    logic                   pipe_empty;
+
+    //--------------------------------------------------------------------------
+    // Activation Buffers
+    //--------------------------------------------------------------------------
+    for (genvar b = 0; b < NUM_BUFS; b++) begin : g_buf
+        localparam int DEPTH = (b == 0) ? MAX_LAYER_SIZE : HID_SIZE;
+
+        (* ram_style = "block" *)
+        fixed_t mem [0:2*DEPTH-1];
+
+        always_ff @(posedge clk) begin
+            if (buf_we[b] && buf_wr_addr[b] < DEPTH)
+                mem[buf_we_half[b] * DEPTH + buf_wr_addr[b]] <= buf_wr_data[b];
+            buf_rd_data[b] <= mem[buf_rd_half[b] * DEPTH + buf_rd_addr[b]];
+        end
+    end
+
+    //--------------------------------------------------------------------------
+    // Layer Engines
+    //--------------------------------------------------------------------------
+    for (genvar k = 0; k < NUM_LAYERS; k++) begin : g_eng
+        nn_layer_engine #(
+            .LAYER   (k),
+            .LANES   (ENG_LANES[k]),
+            .W_DEPTH (ENG_WEIGHTS[k]),
+            .MAX_IN  ((k == 0) ? MAX_LAYER_SIZE : HID_SIZE)
+        ) u_engine (
+            .clk        (clk),
+            .rst_n      (rst_n),
+            .start      (eng_start[k]),
+            .busy       (),
+            .done       (eng_done[k]),
+            .cur_in     (cfg_size[k]),
+            .cur_out    (cfg_size[k+1]),
+            .use_act    (!(raw_out && k == NUM_LAYERS - 1)),
+            .in_addr    (buf_rd_addr[k]),
+            .in_data    (buf_rd_data[k]),
+            .out_we     (buf_we[k+1]),
+            .out_addr   (buf_wr_addr[k+1]),
+            .out_data   (buf_wr_data[k+1]),
+            .ld_start   (ld_start),
+            .ld_we_w    (ld_we_w[k]),
+            .ld_we_b    (ld_we_b[k]),
+            .ld_b_addr  (ld_b_addr),
+            .ld_data    (ld_data)
+        );
+
+        assign buf_rd_half[k]   = eng_src[k];
+        assign buf_we_half[k+1] = eng_dst[k];
+
+        // Next frame in, a free half out
+        assign eng_start[k] = enable && !eng_run[k] &&
+                              buf_full[k][rd_half[k]] && !buf_full[k+1][wr_half[k+1]];
+    end
+
+    assign buf_rd_half[NUM_BUFS-1] = rd_half[NUM_BUFS-1];
+    assign buf_rd_addr[NUM_BUFS-1] = out_idx;
+    assign buf_we[0]               = fe_we;
+    assign buf_we_half[0]          = wr_half[0];
+    assign buf_wr_addr[0]          = fe_wr_addr;
+    assign buf_wr_data[0]          = fe_wr_data;
+
+    assign ld_bias = ld_cnt - num_w;
+
+    //--------------------------------------------------------------------------
+    // Status
+    //--------------------------------------------------------------------------
+    always_comb begin
+        pipe_empty = (fe_state == F_IDLE) && (o_state == O_IDLE) && (eng_run == '0);
+        for (int b = 0; b < NUM_BUFS; b++)
+            if (buf_full[b] != 2'b00)
+                pipe_empty = 1'b0;
+    end
+
+    assign busy = !pipe_empty;
+    assign in_ready = !buf_full[0][wr_half[0]];
+
+    always_comb begin
+        if (fe_state == F_LOAD_W)
+            state = S_LOAD_W;
+        else if (o_state != O_IDLE)
+            state = S_OUTPUT;
+        else if (eng_run != '0)
+            state = S_COMPUTE;
+        else if (fe_state == F_LOAD_IN)
+            state = S_LOAD_IN;
+        else
+            state = done ? S_DONE : S_IDLE;
+    end
+
+    //--------------------------------------------------------------------------
+    // Stream Interfaces
+    //--------------------------------------------------------------------------
+    assign s_axis_tready = enable && (fe_state == F_LOAD_IN || fe_state == F_LOAD_W);
+
+    assign m_axis_tdata  = AXIS_DATA_WIDTH'($signed(buf_rd_data[NUM_BUFS-1]));
+    assign m_axis_tvalid = (o_state == O_SEND) && out_pending;
+    assign m_axis_tlast  = m_axis_tvalid && (out_idx == cfg_size[MAX_LAYERS-1] - 1);
+    assign m_axis_tuser  = {pred_q[rd_half[NUM_BUFS-1]],
+                            margin_q[rd_half[NUM_BUFS-1]],
+                            score_q[rd_half[NUM_BUFS-1]]};
+
+    //--------------------------------------------------------------------------
+    // Output Layer Argmax (on engine 2's writes, first maximum wins)
+    //--------------------------------------------------------------------------
+    nn_argmax u_argmax (
+        .clk        (clk),
+        .rst_n      (rst_n),
+        .valid      (buf_we[NUM_BUFS-1]),
+        .idx        (buf_wr_addr[NUM_BUFS-1]),
+        .value      (buf_wr_data[NUM_BUFS-1]),
+        .best_idx   (best_idx),
+        .best_val   (best_val),
+        .margin     (best_margin)
+    );
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            pred_q   <= '{default: '0};
+            score_q  <= '{default: '0};
+            margin_q <= '{default: '0};
+        end
+        else if (eng_done[NUM_LAYERS-1]) begin
+            pred_q[eng_dst[NUM_LAYERS-1]]   <= best_idx;
+            score_q[eng_dst[NUM_LAYERS-1]]  <= best_val;
+            margin_q[eng_dst[NUM_LAYERS-1]] <= best_margin;
+        end
+    end
+
+    //--------------------------------------------------------------------------
+    // Main Control: front end, buffer handoff, result stage
+    //--------------------------------------------------------------------------
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            fe_state    <= F_IDLE;
+            o_state     <= O_IDLE;
+            done        <= 1'b0;
+            predicted   <= '0;
+            score       <= '0;
+            margin      <= '0;
+            start_q     <= 1'b0;
+            load_q      <= 1'b0;
+            in_cnt      <= '0;
+            ld_cnt      <= '0;
+            ld_layer    <= '0;
+            ld_row      <= '0;
+            ld_col      <= '0;
+            ld_b_addr   <= '0;
+            ld_we_w     <= '0;
+            ld_we_b     <= '0;
+            ld_start    <= 1'b0;
+            ld_data     <= '0;
+            out_idx     <= '0;
+            out_pending <= 1'b0;
+            eng_run     <= '0;
+            fe_we       <= 1'b0;
+            fe_wr_addr  <= '0;
+            fe_wr_data  <= '0;
+            for (int b = 0; b < NUM_BUFS; b++) begin
+                buf_full[b] <= 2'b00;
+                wr_half[b]  <= 1'b0;
+                rd_half[b]  <= 1'b0;
+            end
+            for (int k = 0; k < NUM_LAYERS; k++) begin
+                eng_src[k] <= 1'b0;
+                eng_dst[k] <= 1'b0;
+            end
+            for (int i = 0; i < MAX_LAYERS; i++)
+                cfg_size[i] <= '0;
+        end
+        else begin
+            // Default values
+            fe_we     <= 1'b0;
+            ld_we_w   <= '0;
+            ld_we_b   <= '0;
+            ld_start  <= 1'b0;
+
+            if (start) begin
+                start_q <= 1'b1;
+                load_q  <= load_model;
+            end
+
+            //------------------------------------------------------------------
+            // Front End
+            //------------------------------------------------------------------
+            if (enable) begin
+                case (fe_state)
+                    F_IDLE: begin
+                        if (start_q && load_q) begin
+                            if (pipe_empty) begin
+                                cfg_size[0] <= num_in;
+                                cfg_size[1] <= num_h1;
+                                cfg_size[2] <= num_h2;
+                                cfg_size[3] <= num_out;
+                                ld_cnt      <= '0;
+                                ld_layer    <= '0;
+                                ld_row      <= '0;
+                                ld_col      <= '0;
+                                ld_start    <= 1'b1;
+                                start_q     <= 1'b0;
+                                fe_state    <= F_LOAD_W;
+                            end
+                        end
+                        else if ((start_q || (stream && s_axis_tvalid)) &&
+                                 !buf_full[0][wr_half[0]]) begin
+                            if (pipe_empty) begin
+                                cfg_size[0] <= num_in;
+                                cfg_size[1] <= num_h1;
+                                cfg_size[2] <= num_h2;
+                                cfg_size[3] <= num_out;
+                            end
+                            // A START frame is waited on alone; stale done
+                            // must not satisfy it
+                            if (start_q)
+                                done <= 1'b0;
+                            in_cnt   <= '0;
+                            start_q  <= 1'b0;
+                            fe_state <= F_LOAD_IN;
+                        end
+                    end
+
+                    F_LOAD_IN: begin
+                        if (s_axis_tvalid) begin
+                            fe_wr_addr <= in_cnt;
+                            fe_wr_data <= fixed_t'(s_axis_tdata[DATA_WIDTH-1:0]);
+                            fe_we      <= 1'b1;
+                            in_cnt     <= in_cnt + 1;
+
+                            if (s_axis_tlast || in_cnt == cfg_size[0] - 1)
+                                fe_state <= F_IDLE;
+                        end
+                    end
+
+                    F_LOAD_W: begin
+                        // Weights to the engine of their layer, then biases
+                        if (s_axis_tvalid) begin
+                            ld_data <= fixed_t'(s_axis_tdata[DATA_WIDTH-1:0]);
+                            ld_cnt  <= ld_cnt + 1;
+
+                            if (ld_cnt < num_w) begin
+                                if (ld_layer < NUM_LAYERS)
+                                    ld_we_w[ld_layer] <= 1'b1;
+
+                                if (ld_col == cfg_size[ld_layer] - 1) begin
+                                    ld_col <= '0;
+                                    if (ld_row == cfg_size[ld_layer + 1] - 1) begin
+                                        ld_row   <= '0;
+                                        ld_layer <= ld_layer + 1;
+                                    end
+                                    else begin
+                                        ld_row <= ld_row + 1;
+                                    end
+                                end
+                                else begin
+                                    ld_col <= ld_col + 1;
+                                end
+                            end
+                            else begin
+                                if (ld_bias < cfg_size[1]) begin
+                                    ld_b_addr <= ld_bias;
+                                    ld_we_b   <= 3'b001;
+                                end
+                                else if (ld_bias < cfg_size[1] + cfg_size[2]) begin
+                                    ld_b_addr <= ld_bias - cfg_size[1];
+                                    ld_we_b   <= 3'b010;
+                                end
+                                else begin
+                                    ld_b_addr <= ld_bias - cfg_size[1] - cfg_size[2];
+                                    ld_we_b   <= 3'b100;
+                                end
+                            end
+
+                            if (s_axis_tlast) begin
+                                load_q   <= 1'b0;
+                                fe_state <= F_IDLE;
+                            end
+                        end
+                    end
+
+                    default: fe_state <= F_IDLE;
+                endcase
+            end
+
+            // Input frame complete: hand buf0's half to engine 0
+            if (fe_state == F_LOAD_IN && enable && s_axis_tvalid &&
+                (s_axis_tlast || in_cnt == cfg_size[0] - 1)) begin
+                buf_full[0][wr_half[0]] <= 1'b1;
+                wr_half[0]              <= !wr_half[0];
+            end
+
+            //------------------------------------------------------------------
+            // Engine Handoff
+            //------------------------------------------------------------------
+            for (int k = 0; k < NUM_LAYERS; k++) begin
+                if (eng_start[k]) begin
+                    eng_run[k]   <= 1'b1;
+                    eng_src[k]   <= rd_half[k];
+                    eng_dst[k]   <= wr_half[k+1];
+                    rd_half[k]   <= !rd_half[k];
+                    wr_half[k+1] <= !wr_half[k+1];
+                end
+                if (eng_done[k]) begin
+                    eng_run[k]                <= 1'b0;
+                    buf_full[k][eng_src[k]]   <= 1'b0;
+                    buf_full[k+1][eng_dst[k]] <= 1'b1;
+                end
+            end
+
+            //------------------------------------------------------------------
+            // Result Stage
+            //------------------------------------------------------------------
+            case (o_state)
+                O_IDLE: begin
+                    if (enable && buf_full[NUM_BUFS-1][rd_half[NUM_BUFS-1]]) begin
+                        done        <= 1'b0;
+                        out_idx     <= '0;
+                        out_pending <= 1'b0;
+                        o_state     <= class_only ? O_FINISH : O_SEND;
+                    end
+                end
+
+                O_SEND: begin
+                    // Read one result, hold it on m_axis until accepted
+                    if (!out_pending) begin
+                        out_pending <= 1'b1;
+                    end
+                    else if (m_axis_tready) begin
+                        out_pending <= 1'b0;
+                        if (out_idx == cfg_size[MAX_LAYERS-1] - 1)
+                            o_state <= O_FINISH;
+                        else
+                            out_idx <= out_idx + 1;
+                    end
+                end
+
+                O_FINISH: begin
+                    done      <= 1'b1;
+                    predicted <= pred_q[rd_half[NUM_BUFS-1]];
+                    score     <= score_q[rd_half[NUM_BUFS-1]];
+                    margin    <= margin_q[rd_half[NUM_BUFS-1]];
+                    buf_full[NUM_BUFS-1][rd_half[NUM_BUFS-1]] <= 1'b0;
+                    rd_half[NUM_BUFS-1] <= !rd_half[NUM_BUFS-1];
+                    o_state   <= O_IDLE;
+                end
+
+                default: o_state <= O_IDLE;
+            endcase
+        end
+    end
+
+endmodule
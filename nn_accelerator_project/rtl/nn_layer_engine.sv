@@ -0,0 +1,362 @@
+//==============================================================================
+// File: nn_layer_engine.sv
+// Description: Compute engine for one MLP layer (dataflow core)
+//
+// Evaluates cur_out neurons of one layer for one vector: inputs are read
+// from the upstream activation buffer, activations are written to the
+// downstream one. Sequencing follows nn_accelerator_core: per group of
+// LANES neurons one bias fetch and cur_in MAC cycles, with the group's
+// activation and store overlapped with the next group.
+//
+// Weights: this layer only, in LANES banks; lane l holds the rows of
+// neurons n % LANES == l. The bitstream model comes from
+// nn_model_weights_df_l<LAYER>_lane<l>.mem (export_for_fpga, one group
+// of rows after the other). Model load beats arrive in the layer-major
+// .mem order and are scattered into the banks as in the core.
+//==============================================================================
+
+module nn_layer_engine
+    import nn_pkg::*;
+#(
+    parameter int LAYER   = 0,                  // Layer index (.mem slice)
+    parameter int LANES   = 2,                  // Neuron lanes, power of two
+    parameter int W_DEPTH = 1024,               // Weight capacity
+    parameter int MAX_IN  = MAX_LAYER_SIZE      // Largest cur_in
+)(
+    input  logic        clk,
+    input  logic        rst_n,
+
+    //--------------------------------------------------------------------------
+    // Control
+    //--------------------------------------------------------------------------
+    input  logic        start,          // Run one vector (pulse)
+    output logic        busy,
+    output logic        done,           // Last activation written (pulse)
+    input  logic [15:0] cur_in,
+    input  logic [15:0] cur_out,
+    input  logic        use_act,        // Apply the activation function
+
+    //--------------------------------------------------------------------------
+    // Activation Buffers
+    //--------------------------------------------------------------------------
+    output logic [15:0] in_addr,        // Upstream read, data one cycle later
+    input  fixed_t      in_data,
+    output logic        out_we,         // Downstream write
+    output logic [15:0] out_addr,
+    output fixed_t      out_data,
+
+    //--------------------------------------------------------------------------
+    // Model Load
+    //--------------------------------------------------------------------------
+    input  logic        ld_start,       // Rewind to the first weight
+    input  logic        ld_we_w,        // Next weight beat of this layer
+    input  logic        ld_we_b,
+    input  logic [15:0] ld_b_addr,      // Bias index within this layer
+    input  fixed_t      ld_data
+);
+
+    //--------------------------------------------------------------------------
+    // Parameters
+    //--------------------------------------------------------------------------
+    localparam int LANE_W       = $clog2(LANES);
+    // Layer share per bank plus room for the partial last group
+    localparam int W_BANK_DEPTH = W_DEPTH / LANES + MAX_IN;
+    localparam int W_ADDR_W     = $clog2(W_BANK_DEPTH);
+    localparam int B_ADDR_W     = $clog2(BIAS_MEM_DEPTH);
+
+    // Bitstream model: this layer's slice of nn_model_biases.mem
+    localparam int DEF_SIZE [0:MAX_LAYERS-1] = '{
+        DEFAULT_NUM_IN, DEFAULT_NUM_H1, DEFAULT_NUM_H2, DEFAULT_NUM_OUT
+    };
+
+    function automatic int def_b_offset();
+        int off = 0;
+        for (int k = 0; k < LAYER; k++)
+            off += DEF_SIZE[k+1];
+        return off;
+    endfunction
+
+    if (LANES < 2 || (LANES & (LANES - 1)) != 0) begin : g_check
+        $error("LANES must be a power of two, at least 2");
+    end
+
+    typedef enum logic [1:0] {
+        E_IDLE, E_LOAD_B, E_COMPUTE, E_DRAIN
+    } eng_state_t;
+
+    //--------------------------------------------------------------------------
+    // Memories
+    //--------------------------------------------------------------------------
+    fixed_t bias_mem [0:BIAS_MEM_DEPTH-1];
+    fixed_t b_init   [0:BIAS_MEM_DEPTH-1];
+
+    initial begin
+        $readmemh("nn_model_biases.mem", b_init);
+        for (int n = 0; n < BIAS_MEM_DEPTH; n++)
+            bias_mem[n] = (def_b_offset() + n < BIAS_MEM_DEPTH) ?
+                          b_init[def_b_offset() + n] : '0;
+    end
+
+    //--------------------------------------------------------------------------
+    // Internal Signals
+    //--------------------------------------------------------------------------
+    eng_state_t             state;
+    logic [15:0]            n_base;         // First neuron of current group
+    logic [15:0]            idx;            // Input index being issued
+    logic [W_ADDR_W-1:0]    w_grp_base;     // Bank address of the group's rows
+    logic [W_ADDR_W-1:0]    w_rd_addr;
+    fixed_t                 w_rd_data [0:LANES-1];
+
+    // Result store (runs while the following groups compute)
+    fixed_t                 st_val [0:LANES-1];
+    logic [15:0]            st_base;
+    logic [$clog2(LANES+1)-1:0] store_lane;
+    logic                   st_busy;
+    logic                   st_pend;
+
+    // Model load position
+    logic [15:0]            ld_row;
+    logic [15:0]            ld_col;
+    logic [15:0]            ld_grp_base;
+    logic                   ld_bank_we;
+
+    // Neuron interface
+    logic                   rd_valid;
+    logic                   rd_last;
+    logic                   bias_load;
+    fixed_t                 bias_q     [0:LANES-1];
+    logic [LANES-1:0]       neuron_done;
+    fixed_t                 neuron_out [0:LANES-1];
+
+    // Sigmoid LUT interface
+    logic [SIGMOID_ADDR_WIDTH-1:0] sig_addr [0:LANES-1];
+    fixed_t                        sig_data [0:LANES-1];
+    logic                          sig_en   [0:LANES-1];
+
+    assign busy      = (state != E_IDLE) || st_busy || st_pend;
+    assign in_addr   = idx;
+    assign w_rd_addr = w_grp_base + W_ADDR_W'(idx);
+
+    //--------------------------------------------------------------------------
+    // Model Load: weight position and bias writes
+    //--------------------------------------------------------------------------
+    assign ld_bank_we = ld_we_w && (ld_grp_base + ld_col < W_BANK_DEPTH);
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            ld_row      <= '0;
+            ld_col      <= '0;
+            ld_grp_base <= '0;
+        end
+        else if (ld_start) begin
+            ld_row      <= '0;
+            ld_col      <= '0;
+            ld_grp_base <= '0;
+        end
+        else if (ld_we_w) begin
+            if (ld_col == cur_in - 1) begin
+                ld_col <= '0;
+                ld_row <= ld_row + 1;
+                if (ld_row[LANE_W-1:0] == LANE_W'(LANES - 1))
+                    ld_grp_base <= ld_grp_base + cur_in;
+            end
+            else begin
+                ld_col <= ld_col + 1;
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        if (ld_we_b && ld_b_addr < BIAS_MEM_DEPTH)
+            bias_mem[B_ADDR_W'(ld_b_addr)] <= ld_data;
+    end
+
+    //--------------------------------------------------------------------------
+    // Neuron Lanes: weight bank + neuron
+    //--------------------------------------------------------------------------
+    for (genvar l = 0; l < LANES; l++) begin : g_lane
+        (* ram_style = "block" *)
+        fixed_t bank [0:W_BANK_DEPTH-1];
+
+        initial begin
+            $readmemh($sformatf("nn_model_weights_df_l%0d_lane%0d.mem", LAYER, l), bank);
+        end
+
+        always_ff @(posedge clk) begin
+            if (ld_bank_we && ld_row[LANE_W-1:0] == LANE_W'(l))
+                bank[W_ADDR_W'(ld_grp_base + ld_col)] <= ld_data;
+            w_rd_data[l] <= bank[w_rd_addr];
+        end
+
+        // One input per cycle: the buffers between engines are one value wide
+        fixed_t in_tap [1];
+        fixed_t w_tap  [1];
+
+        assign in_tap[0] = in_data;
+        assign w_tap[0]  = w_rd_data[l];
+
+        nn_neuron #(
+            .TAPS           (1)
+        ) u_neuron (
+            .clk            (clk),
+            .rst_n          (rst_n),
+            .clear          (1'b0),
+            .done           (neuron_done[l]),
+            .busy           (),
+            .input_val      (in_tap),
+            .weight_val     (w_tap),
+            .bias_val       (bias_q[l]),
+            .load_bias      (bias_load),
+            .mac_enable     (rd_valid),
+            .mac_last       (rd_last),
+            .use_activation (use_act),
+            .sigmoid_addr   (sig_addr[l]),
+            .sigmoid_data   (sig_data[l]),
+            .sigmoid_en     (sig_en[l]),
+            .output_val     (neuron_out[l]),
+            .output_valid   ()
+        );
+    end
+
+    //--------------------------------------------------------------------------
+    // Sigmoid LUTs (one dual-port ROM per lane pair; with the other
+    // activations the neurons compute the function themselves)
+    //--------------------------------------------------------------------------
+    for (genvar p = 0; p < LANES / 2; p++) begin : g_sigmoid
+        if (ACTIVATION == ACT_SIGMOID_LUT) begin : g_rom
+            sigmoid_lut u_sigmoid (
+                .clk    (clk),
+                .rst_n  (rst_n),
+                .addr_a (sig_addr[2*p]),
+                .en_a   (sig_en[2*p]),
+                .data_a (sig_data[2*p]),
+                .addr_b (sig_addr[2*p+1]),
+                .en_b   (sig_en[2*p+1]),
+                .data_b (sig_data[2*p+1])
+            );
+        end
+        else begin : g_none
+            assign sig_data[2*p]   = '0;
+            assign sig_data[2*p+1] = '0;
+        end
+    end
+
+    //--------------------------------------------------------------------------
+    // Sequencer
+    //--------------------------------------------------------------------------
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            state      <= E_IDLE;
+            done       <= 1'b0;
+            n_base     <= '0;
+            idx        <= '0;
+            w_grp_base <= '0;
+            st_base    <= '0;
+            store_lane <= '0;
+            st_busy    <= 1'b0;
+            st_pend    <= 1'b0;
+            out_we     <= 1'b0;
+            out_addr   <= '0;
+            out_data   <= '0;
+            rd_valid   <= 1'b0;
+            rd_last    <= 1'b0;
+            bias_load  <= 1'b0;
+            for (int l = 0; l < LANES; l++) begin
+                bias_q[l] <= '0;
+                st_val[l] <= '0;
+            end
+        end
+        else begin
+            done      <= 1'b0;
+            out_we    <= 1'b0;
+            rd_valid  <= 1'b0;
+            rd_last   <= 1'b0;
+            bias_load <= 1'b0;
+
+            case (state)
+                //--------------------------------------------------------------
+                E_IDLE: begin
+                    if (start) begin
+                        n_base     <= '0;
+                        st_base    <= '0;
+                        w_grp_base <= '0;
+                        state      <= E_LOAD_B;
+                    end
+                end
+
+                //--------------------------------------------------------------
+                E_LOAD_B: begin
+                    // At most two groups unstored (store + neuron outputs)
+                    if (n_base - st_base < 16'(2 * LANES)) begin
+                        for (int l = 0; l < LANES; l++)
+                            bias_q[l] <= bias_mem[B_ADDR_W'(n_base) + B_ADDR_W'(l)];
+                        bias_load <= 1'b1;
+                        idx       <= '0;
+                        state     <= E_COMPUTE;
+                    end
+                end
+
+                //--------------------------------------------------------------
+                E_COMPUTE: begin
+                    rd_valid <= 1'b1;
+                    rd_last  <= (idx == cur_in - 1);
+
+                    if (idx == cur_in - 1) begin
+                        if (n_base + LANES >= cur_out) begin
+                            state <= E_DRAIN;
+                        end
+                        else begin
+                            n_base     <= n_base + LANES;
+                            w_grp_base <= w_grp_base + W_ADDR_W'(cur_in);
+                            state      <= E_LOAD_B;
+                        end
+                    end
+                    else begin
+                        idx <= idx + 1;
+                    end
+                end
+
+                //--------------------------------------------------------------
+                E_DRAIN: begin
+                    // Last group activated and stored
+                    if (st_base > n_base) begin
+                        done  <= 1'b1;
+                        state <= E_IDLE;
+                    end
+                end
+
+                default: state <= E_IDLE;
+            endcase
+
+            //------------------------------------------------------------------
+            // Result Store
+            //------------------------------------------------------------------
+            if (st_busy) begin
+                if (st_base + store_lane < cur_out) begin
+                    out_addr <= st_base + store_lane;
+                    out_data <= st_val[store_lane];
+                    out_we   <= 1'b1;
+                end
+
+                if (store_lane == LANES - 1) begin
+                    st_busy <= 1'b0;
+                    st_base <= st_base + LANES;
+                end
+                else begin
+                    store_lane <= store_lane + 1;
+                end
+
+                if (neuron_done[0])
+                    st_pend <= 1'b1;
+            end
+            else if (neuron_done[0] || st_pend) begin
+                for (int l = 0; l < LANES; l++)
+                    st_val[l] <= neuron_out[l];
+                store_lane <= '0;
+                st_busy    <= 1'b1;
+                st_pend    <= 1'b0;
+            end
+        end
+    end
+
+endmodule
@@ -2,65 +2,172 @@
 // File: nn_mac.sv
 // Description: Multiply-Accumulate unit for neural network computation
 //
-// Performs: accumulator += input * weight
+// Performs: accumulator += sum(input[t] * weight[t]), t < TAPS
 // Supports bias loading and accumulator clearing
+//
+// Fully registered for DSP48E1 mapping; all inputs take effect
+// 2 + $clog2(TAPS) cycles after they are presented (MAC_PIPE_STAGES for
+// TAPS = IN_PARALLEL).
 //==============================================================================
 
 module nn_mac
     import nn_pkg::*;
-(
+#(
+    parameter int TAPS = 1                  // Products per cycle, power of two
+)(
     input  logic    clk,
     input  logic    rst_n,
     
     // Control
     input  logic    clear,          // Clear accumulator
     input  logic    enable,         // Enable MAC operation
+    input  logic    last,           // With enable: final MAC of the sum
     input  logic    load_bias,      // Load bias into accumulator
     
     // Data inputs
-    input  fixed_t  input_val,      // Input activation
-    input  fixed_t  weight_val,     // Weight value
+    input  fixed_t  input_val [TAPS],  // Input activations
+    input  fixed_t  weight_val [TAPS], // Weight values
     input  fixed_t  bias_val,       // Bias value
     
     // Output
     output fixed_t  result,         // Saturated result
     output accum_t  accumulator,    // Raw accumulator (for debugging)
-    output logic    valid           // Result valid (one cycle after last MAC)
+    output logic    valid           // Result holds the sum ended by last
 );
 
     //--------------------------------------------------------------------------
     // Internal Signals
+    // Pipeline (one DSP48E1 per tap): A/B input registers -> M product
+    // registers -> ADD_STAGES registered pairwise adder levels -> P
+    // accumulator, which adds the one remaining sum. clear/load_bias/
+    // enable and the bias travel with the data, so the accumulator
+    // updates 2 + ADD_STAGES cycles after the inputs.
     //--------------------------------------------------------------------------
-    accum_t accum_reg;
-    accum_t product;
-    logic   enable_d1;
+    localparam int ADD_STAGES = $clog2(TAPS);
+
+    typedef logic signed [MAC_ACC_WIDTH-1:0] macc_t;
+
+    (* use_dsp = "yes" *) macc_t accum_reg;
+    fixed_t a_reg [TAPS];
+    fixed_t b_reg [TAPS];
+    fixed_t bias_reg;
+    accum_t m_reg [TAPS];
+    macc_t  node  [2*TAPS-1];       // Adder tree, heap order, node[0] = root
+    macc_t  m_sum;
+    logic   clear_d1, load_d1, enable_d1, last_d1;
+    logic   clear_p  [ADD_STAGES+1]; // Control and bias, index = tree level
+    logic   load_p   [ADD_STAGES+1];
+    logic   enable_p [ADD_STAGES+1];
+    logic   last_p   [ADD_STAGES+1];
+    fixed_t bias_p   [ADD_STAGES+1];
+    logic   last_d3;
+    macc_t  accum_shift;
     
+    if (TAPS < 1 || (TAPS & (TAPS - 1)) != 0) begin : g_check
+        $error("TAPS must be a power of two");
+    end
+
     //--------------------------------------------------------------------------
-    // Multiply (combinational)
+    // Stage 1: Input Registers (AREG/BREG)
     //--------------------------------------------------------------------------
-    assign product = fixed_mult(input_val, weight_val);
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            for (int t = 0; t < TAPS; t++) begin
+                a_reg[t] <= '0;
+                b_reg[t] <= '0;
+            end
+            bias_reg  <= '0;
+            clear_d1  <= 1'b0;
+            load_d1   <= 1'b0;
+            enable_d1 <= 1'b0;
+            last_d1   <= 1'b0;
+        end
+        else begin
+            a_reg     <= input_val;
+            b_reg     <= weight_val;
+            bias_reg  <= bias_val;
+            clear_d1  <= clear;
+            load_d1   <= load_bias;
+            enable_d1 <= enable;
+            last_d1   <= enable && last;
+        end
+    end
+    
+    //--------------------------------------------------------------------------
+    // Stage 2: Multiply (MREG), control delayed along the adder tree
+    //--------------------------------------------------------------------------
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            for (int t = 0; t < TAPS; t++)
+                m_reg[t] <= '0;
+            for (int s = 0; s <= ADD_STAGES; s++) begin
+                clear_p[s]  <= 1'b0;
+                load_p[s]   <= 1'b0;
+                enable_p[s] <= 1'b0;
+                last_p[s]   <= 1'b0;
+                bias_p[s]   <= '0;
+            end
+        end
+        else begin
+            for (int t = 0; t < TAPS; t++)
+                m_reg[t] <= fixed_mult(a_reg[t], b_reg[t]);
+            clear_p[0]  <= clear_d1;
+            load_p[0]   <= load_d1;
+            enable_p[0] <= enable_d1;
+            last_p[0]   <= last_d1;
+            bias_p[0]   <= bias_reg;
+            for (int s = 1; s <= ADD_STAGES; s++) begin
+                clear_p[s]  <= clear_p[s-1];
+                load_p[s]   <= load_p[s-1];
+                enable_p[s] <= enable_p[s-1];
+                last_p[s]   <= last_p[s-1];
+                bias_p[s]   <= bias_p[s-1];
+            end
+        end
+    end
     
     //--------------------------------------------------------------------------
-    // Accumulate (sequential)
+    // Adder Tree: one registered level per pairwise reduction, so no carry
+    // chain sits between the product registers and the P register. Sums
+    // wrap like a sequential accumulation, so the result does not depend
+    // on TAPS.
+    //--------------------------------------------------------------------------
+    for (genvar t = 0; t < TAPS; t++) begin : g_leaf
+        assign node[TAPS-1+t] = macc_t'(m_reg[t]);
+    end
+
+    for (genvar n = 0; n < TAPS-1; n++) begin : g_node
+        always_ff @(posedge clk or negedge rst_n) begin
+            if (!rst_n)
+                node[n] <= '0;
+            else
+                node[n] <= node[2*n+1] + node[2*n+2];
+        end
+    end
+
+    assign m_sum = node[0];
+
+    //--------------------------------------------------------------------------
+    // Stage 3: Accumulate (PREG, post-adder feedback)
     //--------------------------------------------------------------------------
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             accum_reg <= '0;
-            enable_d1 <= 1'b0;
+            last_d3   <= 1'b0;
         end
         else begin
-            enable_d1 <= enable;
+            last_d3   <= last_p[ADD_STAGES];
             
-            if (clear) begin
+            if (clear_p[ADD_STAGES]) begin
                 accum_reg <= '0;
             end
-            else if (load_bias) begin
+            else if (load_p[ADD_STAGES]) begin
                 // Load bias (already in fixed-point, shift to accumulator scale)
-                accum_reg <= accum_t'(bias_val) <<< FRAC_BITS;
+                accum_reg <= macc_t'(bias_p[ADD_STAGES]) <<< FRAC_BITS;
             end
-            else if (enable) begin
-                // Accumulate product
-                accum_reg <= accum_reg + product;
+            else if (enable_p[ADD_STAGES]) begin
+                // Accumulate products
+                accum_reg <= accum_reg + m_sum;
             end
         end
     end
@@ -69,10 +176,21 @@ module nn_mac
     // Output
     //--------------------------------------------------------------------------
     // Shift right by FRAC_BITS and saturate to 16-bit
-    assign result = saturate(accum_reg >>> FRAC_BITS);
-    assign accumulator = accum_reg;
+    assign accum_shift = accum_reg >>> FRAC_BITS;
+
+    always_comb begin
+        if (accum_shift > macc_t'(32767))
+            result = 16'sd32767;
+        else if (accum_shift < -macc_t'(32768))
+            result = -16'sd32768;
+        else
+            result = fixed_t'(accum_shift);
+    end
+
+    assign accumulator = accum_t'(accum_reg);
     
-    // Valid pulse after enable goes low
-    assign valid = enable_d1 && !enable;
+    // Valid for the one cycle the finished sum is held; enables may have
+    // gaps, so the end of a sum is marked, not inferred
+    assign valid = last_d3;
 
 endmodule
@@ -1,32 +1,45 @@
 //==============================================================================
 // File: nn_neuron.sv
-// Description: Single neuron with MAC and sigmoid activation
+// Description: Single neuron with MAC and activation
 //
-// Operation: output = sigmoid(sum(input[i] * weight[i]) + bias)
+// Operation: output = act(sum(input[i] * weight[i]) + bias)
+//
+// With ACTIVATION == ACT_SIGMOID_LUT act is read from the shared sigmoid
+// ROM through the sigmoid port; otherwise the neuron has its own
+// nn_activation unit and the sigmoid port is unused.
+//
+// The MAC is sequenced externally (load_bias, then one mac_enable per
+// TAPS inputs, mac_last on the final ones; enables need not be contiguous). The
+// activation runs as a separate epilogue, so load_bias for the next neuron
+// may follow the last mac_enable directly; done pulses 2 + $clog2(TAPS) + 4
+// cycles (MAC_PIPE_STAGES + 4 for TAPS = IN_PARALLEL) after the last
+// mac_enable.
 //==============================================================================
 
 module nn_neuron
     import nn_pkg::*;
-(
+#(
+    parameter int TAPS = 1          // Inputs per mac_enable
+)(
     input  logic    clk,
     input  logic    rst_n,
     
     //--------------------------------------------------------------------------
     // Control Interface
     //--------------------------------------------------------------------------
-    input  logic    start,          // Start computation
     input  logic    clear,          // Clear state
     output logic    done,           // Computation complete
-    output logic    busy,           // Neuron is busy
+    output logic    busy,           // Activation in progress
     
     //--------------------------------------------------------------------------
     // Data Interface
     //--------------------------------------------------------------------------
-    input  fixed_t  input_val,      // Input value
-    input  fixed_t  weight_val,     // Weight value
+    input  fixed_t  input_val [TAPS],  // Input values
+    input  fixed_t  weight_val [TAPS], // Weight values
     input  fixed_t  bias_val,       // Bias value
     input  logic    load_bias,      // Load bias signal
     input  logic    mac_enable,     // MAC enable signal
+    input  logic    mac_last,       // With mac_enable: last input
     input  logic    use_activation, // Apply sigmoid activation
     
     //--------------------------------------------------------------------------
@@ -46,26 +59,30 @@ module nn_neuron
     //--------------------------------------------------------------------------
     // Internal Signals
     //--------------------------------------------------------------------------
-    neuron_state_t state, next_state;
     fixed_t mac_result;
+    logic   mac_valid;
     fixed_t pre_activation;
-    logic [2:0] wait_cnt;
+    logic   sig_valid;      // sigmoid_data / act_val hold pre_activation's result
+    fixed_t act_val;
     
     //--------------------------------------------------------------------------
     // MAC Unit Instance
     //--------------------------------------------------------------------------
-    nn_mac u_mac (
+    nn_mac #(
+        .TAPS       (TAPS)
+    ) u_mac (
         .clk        (clk),
         .rst_n      (rst_n),
         .clear      (clear),
         .enable     (mac_enable),
+        .last       (mac_last),
         .load_bias  (load_bias),
         .input_val  (input_val),
         .weight_val (weight_val),
         .bias_val   (bias_val),
         .result     (mac_result),
         .accumulator(),
-        .valid      ()
+        .valid      (mac_valid)
     );
     
     //--------------------------------------------------------------------------
@@ -85,93 +102,69 @@ module nn_neuron
             sigmoid_addr = {SIGMOID_ADDR_WIDTH{1'b1}};
         end
         else begin
-            // Take bits [FRAC_BITS+3 : FRAC_BITS-6] to get 10-bit address
-            sigmoid_addr = shifted[FRAC_BITS+3:FRAC_BITS-6];
+            // 16.0 (bit FRAC_BITS+8 of shifted) spans the 1024 entries
+            sigmoid_addr = shifted[FRAC_BITS+7:FRAC_BITS-2];
         end
     end
     
     //--------------------------------------------------------------------------
-    // State Machine
+    // In-Lane Activation (same latency as the ROM read)
+    //--------------------------------------------------------------------------
+    if (ACTIVATION != ACT_SIGMOID_LUT) begin : g_act
+        nn_activation u_act (
+            .clk    (clk),
+            .x      (pre_activation),
+            .en     (sigmoid_en),
+            .y      (act_val)
+        );
+    end
+    else begin : g_no_act
+        assign act_val = '0;
+    end
+    
+    //--------------------------------------------------------------------------
+    // Activation Epilogue
+    // mac_valid marks the one cycle the accumulator holds the finished sum
+    // (the next neuron's bias load may land on the following edge). Capture it
+    // and finish the sigmoid here while the MAC starts the next neuron.
     //--------------------------------------------------------------------------
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
-            state          <= N_IDLE;
             done           <= 1'b0;
-            busy           <= 1'b0;
             output_valid   <= 1'b0;
             output_val     <= '0;
             pre_activation <= '0;
-            wait_cnt       <= '0;
             sigmoid_en     <= 1'b0;
+            sig_valid      <= 1'b0;
         end
         else begin
-            // Default values
             done         <= 1'b0;
             output_valid <= 1'b0;
-            sigmoid_en   <= 1'b0;
             
-            case (state)
-                //--------------------------------------------------------------
-                N_IDLE: begin
-                    busy <= 1'b0;
-                    if (start) begin
-                        state <= N_MAC;
-                        busy  <= 1'b1;
-                    end
-                end
-                
-                //--------------------------------------------------------------
-                N_MAC: begin
-                    // Wait for MAC operations (driven externally)
-                    // Transition triggered by external signal
-                    if (!mac_enable && !load_bias) begin
-                        state    <= N_WAIT;
-                        wait_cnt <= 3'd2; // Wait for pipeline
-                    end
-                end
-                
-                //--------------------------------------------------------------
-                N_WAIT: begin
-                    if (wait_cnt == 0) begin
-                        pre_activation <= mac_result;
-                        state          <= N_ACTIVATE;
-                        sigmoid_en     <= 1'b1;
-                    end
-                    else begin
-                        wait_cnt <= wait_cnt - 1;
-                    end
-                end
-                
-                //--------------------------------------------------------------
-                N_ACTIVATE: begin
-                    // Wait for sigmoid LUT read (1 cycle)
-                    sigmoid_en <= 1'b1;
-                    state      <= N_OUTPUT;
-                end
-                
-                //--------------------------------------------------------------
-                N_OUTPUT: begin
-                    if (use_activation) begin
-                        output_val <= sigmoid_data;
-                    end
-                    else begin
-                        output_val <= pre_activation;
-                    end
-                    output_valid <= 1'b1;
-                    done         <= 1'b1;
-                    state        <= N_IDLE;
-                end
-                
-                //--------------------------------------------------------------
-                default: state <= N_IDLE;
-            endcase
+            // Accumulator -> LUT address register
+            if (mac_valid)
+                pre_activation <= mac_result;
+            sigmoid_en <= mac_valid;
+            
+            // LUT read / activation unit (1 cycle)
+            sig_valid <= sigmoid_en;
+            
+            // Output
+            if (sig_valid) begin
+                output_val   <= !use_activation ? pre_activation :
+                                (ACTIVATION == ACT_SIGMOID_LUT) ? sigmoid_data : act_val;
+                output_valid <= 1'b1;
+                done         <= 1'b1;
+            end
             
             // Clear handling
             if (clear) begin
-                state <= N_IDLE;
-                busy  <= 1'b0;
+                sigmoid_en <= 1'b0;
+                sig_valid  <= 1'b0;
             end
         end
     end
+    
+    assign busy = sigmoid_en || sig_valid;
 
 endmodule
@@ -21,9 +21,59 @@ package nn_pkg;
     // Network Parameters
     //--------------------------------------------------------------------------
     parameter int MAX_LAYER_SIZE    = 784;   // Maximum neurons in a layer
-    parameter int NUM_PARALLEL      = 2;     // Parallel compute units
+    parameter int NUM_PARALLEL      = 2;     // Neuron lanes: 2, 4, 8, 16 or 32
     parameter int MAX_LAYERS        = 4;     // Maximum number of layers
     
+    // Inputs per lane per cycle: 1, 2, 4 or 8. Weight banks hold words of
+    // IN_PARALLEL consecutive row weights (4 = 64-bit, 8 = 128-bit words)
+    // and each MAC sums IN_PARALLEL products per cycle.
+    parameter int IN_PARALLEL       = 4;
+    
+    // MAC: cycles before a MAC input reaches the accumulator (A/B and M
+    // registers plus one registered adder-tree level per doubling of
+    // IN_PARALLEL; the dataflow engines' one-tap MACs take 2), and
+    // accumulator width. The accumulator wraps at MAC_ACC_WIDTH bits and
+    // only the result is clamped to 16 bits. 32 wraps exactly like accum_t;
+    // 48 uses the full DSP48E1 P register, where MAX_LAYER_SIZE S.4.11
+    // products (< 2^40) never reach the wrap. NN_ModelReference() and
+    // network.py forward_fixed() mirror the 32-bit wrap only, so they are
+    // bit-exact with MAC_ACC_WIDTH = 32 and may differ at 48.
+    parameter int MAC_PIPE_STAGES   = 2 + $clog2(IN_PARALLEL);
+    parameter int MAC_ACC_WIDTH     = 32;
+    
+    // Layer 0's first neuron group takes pixels straight from s_axis while
+    // they are stored (S_LOAD_IN and its compute become one phase)
+    parameter int STREAM_LAYER0     = 1;
+    
+    // Layer 0 iterates only over the input words that hold a nonzero
+    // pixel, listed as the frame is stored (groups after a streamed group 0)
+    parameter int ZERO_SKIP         = 1;
+    
+    // m_axis_tuser side-band of the result stream: {class[3:0],
+    // margin[15:0], score[15:0]} from the output layer's nn_argmax
+    parameter int RESULT_TUSER_WIDTH = 36;
+    
+    // Core selection: 0 = layer-sequential nn_accelerator_core,
+    // 1 = layer-pipelined nn_dataflow_core (one engine per layer)
+    parameter int DATAFLOW          = 0;
+    
+    // Dataflow engines: lanes (power of two) and weight capacity per layer.
+    // Layer 0 issues num_in MAC cycles per group, so 16 lanes make it take
+    // about as long as the 784-beat input stream for the default model.
+    parameter int DF_L0_PARALLEL    = 16;
+    parameter int DF_L1_PARALLEL    = 2;
+    parameter int DF_L2_PARALLEL    = 2;
+    parameter int DF_L0_WEIGHTS     = 14336;
+    parameter int DF_L1_WEIGHTS     = 1024;
+    parameter int DF_L2_WEIGHTS     = 1024;
+    
+    // Topology of the bitstream model (784 -> 16 -> 16 -> 10), also the
+    // reset value of the NUM_* registers
+    parameter logic [15:0] DEFAULT_NUM_IN  = 16'd784;
+    parameter logic [15:0] DEFAULT_NUM_H1  = 16'd16;
+    parameter logic [15:0] DEFAULT_NUM_H2  = 16'd16;
+    parameter logic [15:0] DEFAULT_NUM_OUT = 16'd10;
+    
     //--------------------------------------------------------------------------
     // Memory Parameters
     //--------------------------------------------------------------------------
@@ -32,12 +82,30 @@ package nn_pkg;
     parameter int SIGMOID_LUT_SIZE  = 1024;  // Sigmoid LUT entries
     parameter int SIGMOID_ADDR_WIDTH = 10;   // log2(1024)
     
+    //--------------------------------------------------------------------------
+    // Activation Function
+    //   ACT_SIGMOID_LUT:    SIGMOID_LUT_SIZE-entry block ROM per lane pair
+    //   ACT_SIGMOID_INTERP: SIGMOID_INTERP_SEGS-segment linear sigmoid
+    //   ACT_HARD_SIGMOID:   clamp(x/4 + 0.5, 0, 1)
+    //   ACT_RELU:           max(x, 0)
+    // All but the first run in a per-lane nn_activation without BRAM.
+    //--------------------------------------------------------------------------
+    parameter int ACT_SIGMOID_LUT    = 0;
+    parameter int ACT_SIGMOID_INTERP = 1;
+    parameter int ACT_HARD_SIGMOID   = 2;
+    parameter int ACT_RELU           = 3;
+    
+    // The committed model was trained and exported against the LUT sigmoid
+    parameter int ACTIVATION          = ACT_SIGMOID_LUT;
+    parameter int SIGMOID_INTERP_SEGS = 64;  // Power of two, up to 2048
+    
     //--------------------------------------------------------------------------
     // Data Types
     //--------------------------------------------------------------------------
     typedef logic signed [DATA_WIDTH-1:0]     fixed_t;    // Fixed-point data
     typedef logic signed [2*DATA_WIDTH-1:0]   accum_t;    // Accumulator (32-bit)
     typedef logic [SIGMOID_ADDR_WIDTH-1:0]    sig_addr_t; // Sigmoid address
+    typedef logic [IN_PARALLEL*DATA_WIDTH-1:0] fixed_vec_t; // Wide memory word
     
     //--------------------------------------------------------------------------
     // FSM States
@@ -50,24 +118,12 @@ package nn_pkg;
         S_LOAD_B     = 4'd4,
         S_COMPUTE    = 4'd5,
         S_ACTIVATE   = 4'd6,
-        S_STORE      = 4'd7,
+        S_STORE      = 4'd7,        // Unused: stores overlap S_LOAD_B/S_COMPUTE
         S_NEXT_LAYER = 4'd8,
         S_OUTPUT     = 4'd9,
         S_DONE       = 4'd10
     } state_t;
     
-    //--------------------------------------------------------------------------
-    // Neuron States
-    //--------------------------------------------------------------------------
-    typedef enum logic [2:0] {
-        N_IDLE       = 3'd0,
-        N_LOAD_BIAS  = 3'd1,
-        N_MAC        = 3'd2,
-        N_WAIT       = 3'd3,
-        N_ACTIVATE   = 3'd4,
-        N_OUTPUT     = 3'd5
-    } neuron_state_t;
-    
     //--------------------------------------------------------------------------
     // Functions
     //--------------------------------------------------------------------------
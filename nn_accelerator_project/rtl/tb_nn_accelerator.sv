@@ -1,11 +1,16 @@
 //==============================================================================
 // File: tb_nn_accelerator.sv
 // Description: Testbench for neural network accelerator
+//
+// Runs the layer-sequential core; tb_nn_accelerator_df runs the same
+// checks on the dataflow core (DATAFLOW = 1).
 //==============================================================================
 
 `timescale 1ns / 1ps
 
-module tb_nn_accelerator;
+module tb_nn_accelerator #(
+    parameter int DATAFLOW = 0      // DUT compute core
+);
 
     import nn_pkg::*;
     
@@ -52,6 +57,7 @@ module tb_nn_accelerator;
     logic        m_axis_tvalid;
     logic        m_axis_tready;
     logic        m_axis_tlast;
+    logic [35:0] m_axis_tuser;
     
     // Interrupt
     logic        interrupt;
@@ -62,7 +68,8 @@ module tb_nn_accelerator;
     nn_accelerator #(
         .C_S_AXI_ADDR_WIDTH(6),
         .C_S_AXI_DATA_WIDTH(32),
-        .C_AXIS_DATA_WIDTH(32)
+        .C_AXIS_DATA_WIDTH(32),
+        .DATAFLOW(DATAFLOW)
     ) dut (
         .aclk           (clk),
         .aresetn        (rst_n),
@@ -96,6 +103,7 @@ module tb_nn_accelerator;
         .m_axis_tvalid  (m_axis_tvalid),
         .m_axis_tready  (m_axis_tready),
         .m_axis_tlast   (m_axis_tlast),
+        .m_axis_tuser   (m_axis_tuser),
         
         .interrupt      (interrupt)
     );
@@ -165,15 +173,34 @@ module tb_nn_accelerator;
         end
     endtask
     
+    //--------------------------------------------------------------------------
+    // AXI-Stream Output Capture
+    //--------------------------------------------------------------------------
+    logic [15:0] out_data [0:63];
+    integer      out_count;
+
+    always @(posedge clk) begin
+        if (!rst_n) begin
+            out_count <= 0;
+        end
+        else if (m_axis_tvalid && m_axis_tready) begin
+            out_data[out_count] <= m_axis_tdata[15:0];
+            out_count           <= out_count + 1;
+        end
+    end
+
     //--------------------------------------------------------------------------
     // Test Stimulus
     //--------------------------------------------------------------------------
     logic [31:0] read_data;
     integer i;
+    integer best;
+    integer second;
     
     initial begin
         $display("========================================");
-        $display("NN Accelerator Testbench");
+        $display("NN Accelerator Testbench (%s core)",
+                 DATAFLOW ? "dataflow" : "sequential");
         $display("========================================");
         
         // Initialize signals
@@ -220,7 +247,7 @@ module tb_nn_accelerator;
         
         // Enable and start
         $display("Starting inference...");
-        axi_write(6'h00, 32'h03);  // Enable + Start
+        axi_write(6'h00, 32'h13);  // Continuous + Enable + Start
         
         // Send test input data (784 values)
         $display("Sending input data...");
@@ -239,13 +266,116 @@ module tb_nn_accelerator;
         $display("Status = 0x%08X (Busy=%b, Done=%b)", 
                  read_data, read_data[0], read_data[1]);
         
-        // Receive output data
-        $display("Output results:");
+        // Output data was streamed before DONE was raised
+        $display("Output results (%0d received):", out_count);
+        for (i = 0; i < out_count; i++) begin
+            $display("  Output[%d] = 0x%04X", i, out_data[i]);
+        end
+        
+        // Second image back to back, no soft reset in between
+        $display("Starting back-to-back inference...");
+        axi_write(6'h00, 32'h13);  // Continuous + Enable + Start
+        for (i = 0; i < 784; i++) begin
+            axis_send(16'h0100, (i == 783));
+        end
+        wait(!interrupt);
+        wait(interrupt);
+        
+        $display("Back-to-back outputs (%0d received):", out_count - 10);
+        for (i = 10; i < out_count; i++) begin
+            $display("  Output[%d] = 0x%04X", i - 10, out_data[i]);
+            if (out_data[i] !== out_data[i - 10])
+                $display("ERROR: Output[%0d] differs from first run", i - 10);
+        end
+        
+        // Same image, class only: no result beats, argmax in STATUS[11:8]
+        $display("Starting class-only inference...");
+        axi_write(6'h00, 32'h53);  // Class only + Continuous + Enable + Start
+        for (i = 0; i < 784; i++) begin
+            axis_send(16'h0100, (i == 783));
+        end
+        wait(!interrupt);
+        wait(interrupt);
+        
+        best = 0;
+        for (i = 1; i < 10; i++) begin
+            if ($signed(out_data[i]) > $signed(out_data[best]))
+                best = i;
+        end
+        axi_read(6'h04, read_data);
+        $display("  Predicted class = %0d (expected %0d)", read_data[11:8], best);
+        if (read_data[11:8] != best)
+            $display("ERROR: STATUS class does not match output argmax");
+        if (out_count != 20)
+            $display("ERROR: class-only run streamed %0d results", out_count - 20);
+        
+        // Score and top-2 margin of the same run
+        second = (best == 0) ? 1 : 0;
         for (i = 0; i < 10; i++) begin
-            wait(m_axis_tvalid);
-            $display("  Output[%d] = 0x%04X", i, m_axis_tdata[15:0]);
-            @(posedge clk);
+            if (i != best && $signed(out_data[i]) > $signed(out_data[second]))
+                second = i;
+        end
+        axi_read(6'h2C, read_data);
+        $display("  Score = 0x%04X, margin = %0d", read_data[15:0], read_data[31:16]);
+        if (read_data[15:0] != out_data[best])
+            $display("ERROR: SCORE does not match the predicted output");
+        if (read_data[31:16] != 16'($signed(out_data[best]) - $signed(out_data[second])))
+            $display("ERROR: SCORE margin does not match the top-2 outputs");
+        
+        // Upload an all-zero model: every output is then the same sigmoid(0)
+        $display("Uploading zero model...");
+        axi_write(6'h1C, 32'd12960);  // NUM_W = 784*16 + 16*16 + 16*10
+        axi_write(6'h00, 32'h33);     // Load + Continuous + Enable + Start
+        for (i = 0; i < 12960 + 42; i++) begin
+            axis_send(16'h0000, (i == 12960 + 41));
+        end
+        repeat(5) @(posedge clk);
+        axi_read(6'h18, read_data);
+        $display("  MODEL_HASH after load = 0x%08X", read_data);
+        axi_write(6'h18, 32'h00C0FFEE);  // Driver tags the resident model
+        
+        axi_write(6'h00, 32'h13);  // Continuous + Enable + Start
+        for (i = 0; i < 784; i++) begin
+            axis_send(16'h0100, (i == 783));
+        end
+        wait(!interrupt);
+        wait(interrupt);
+        
+        $display("Zero-model outputs (%0d received):", out_count - 20);
+        for (i = 20; i < out_count; i++) begin
+            $display("  Output[%d] = 0x%04X", i - 20, out_data[i]);
+            if (out_data[i] !== out_data[20])
+                $display("ERROR: Output[%0d] differs from Output[0]", i - 20);
+        end
+        
+        // Stream mode, two frames back to back: the second frame goes into
+        // the free input bank while the first one computes
+        $display("Streaming two frames...");
+        axi_write(6'h00, 32'h09);  // Stream + Enable
+        for (i = 0; i < 784; i++) begin
+            axis_send(16'h0100, (i == 783));
         end
+        for (i = 0; i < 784; i++) begin
+            axis_send(16'h0100, (i == 783));
+        end
+        if (out_count != 30)
+            $display("ERROR: second frame waited for the first one's results");
+        wait(out_count == 50);
+        repeat(5) @(posedge clk);
+        for (i = 30; i < out_count; i++) begin
+            if (out_data[i] !== out_data[20])
+                $display("ERROR: Streamed Output[%0d] differs", i - 30);
+        end
+        
+        // Completions are counted even with coalescing off
+        axi_read(6'h28, read_data);
+        $display("IRQ_STATUS = %0d pending completions", read_data);
+        if (read_data != 6)
+            $display("ERROR: expected 6 pending completions");
+        axi_write(6'h28, read_data);  // Acknowledge them
+        axi_read(6'h28, read_data);
+        if (read_data != 0)
+            $display("ERROR: %0d completions left after acknowledge", read_data);
         
         // Done
         repeat(10) @(posedge clk);
@@ -259,7 +389,7 @@ module tb_nn_accelerator;
     // Timeout
     //--------------------------------------------------------------------------
     initial begin
-        #1000000;
+        #5000000;
         $display("ERROR: Timeout!");
         $finish;
     end
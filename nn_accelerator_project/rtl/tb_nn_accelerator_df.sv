@@ -0,0 +1,17 @@
+//==============================================================================
+// File: tb_nn_accelerator_df.sv
+// Description: tb_nn_accelerator on the layer-pipelined dataflow core
+//
+// Repeats the output, back-to-back, class-only, model-upload, stream and
+// IRQ_STATUS checks with DATAFLOW = 1, whatever nn_pkg selects.
+//==============================================================================
+
+`timescale 1ns / 1ps
+
+module tb_nn_accelerator_df;
+
+    tb_nn_accelerator #(
+        .DATAFLOW(1)
+    ) tb ();
+
+endmodule
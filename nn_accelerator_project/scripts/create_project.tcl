@@ -18,7 +18,7 @@ set part_number  "xc7z020clg400-1"  ;# ZYBO/ZedBoard - change for your board
 # Source directories (relative to this script)
 set script_dir [file dirname [info script]]
 set rtl_dir    [file join $script_dir "../rtl"]
-set mem_dir    [file join $script_dir "../mem"]
+set mem_dir    [file join $script_dir "../rtl/mem"]
 set xdc_dir    [file join $script_dir "../constraints"]
 
 #------------------------------------------------------------------------------
@@ -43,8 +43,13 @@ puts "\nAdding RTL sources..."
 set rtl_files [list \
     [file join $rtl_dir "nn_pkg.sv"] \
     [file join $rtl_dir "sigmoid_lut.sv"] \
+    [file join $rtl_dir "nn_activation.sv"] \
     [file join $rtl_dir "nn_mac.sv"] \
     [file join $rtl_dir "nn_neuron.sv"] \
+    [file join $rtl_dir "nn_argmax.sv"] \
+    [file join $rtl_dir "nn_accelerator_core.sv"] \
+    [file join $rtl_dir "nn_layer_engine.sv"] \
+    [file join $rtl_dir "nn_dataflow_core.sv"] \
     [file join $rtl_dir "nn_accelerator.sv"] \
 ]
 
@@ -63,11 +68,75 @@ foreach f $rtl_files {
 puts "\nAdding memory files..."
 
 set mem_files [list \
-    [file join $mem_dir "weights.mem"] \
-    [file join $mem_dir "biases.mem"] \
+    [file join $mem_dir "nn_model_weights.mem"] \
+    [file join $mem_dir "nn_model_biases.mem"] \
     [file join $mem_dir "sigmoid_lut.mem"] \
+    [file join $mem_dir "sigmoid_interp.mem"] \
 ]
 
+# Per-lane weight banks of the sequential core: one file per NUM_PARALLEL
+# lane, IN_PARALLEL weights per word. A missing or mismatched file would
+# synthesize an empty or garbled bank, so stop here instead.
+set fp [open [file join $rtl_dir "nn_pkg.sv"] r]
+set pkg_src [read $fp]
+close $fp
+if {![regexp {parameter int NUM_PARALLEL\s*=\s*(\d+)} $pkg_src -> num_lanes] ||
+    ![regexp {parameter int IN_PARALLEL\s*=\s*(\d+)} $pkg_src -> in_parallel]} {
+    error "NUM_PARALLEL / IN_PARALLEL not found in nn_pkg.sv"
+}
+
+for {set l 0} {$l < $num_lanes} {incr l} {
+    set f [file join $mem_dir "nn_model_weights_lane$l.mem"]
+    if {![file exists $f]} {
+        error "Missing $f: run python/train.py with lanes=$num_lanes, in_parallel=$in_parallel"
+    }
+
+    # First data word must hold IN_PARALLEL 16-bit weights
+    set fp [open $f r]
+    set word ""
+    while {[gets $fp line] >= 0} {
+        set line [string trim $line]
+        if {$line ne "" && ![string match "//*" $line]} {
+            set word $line
+            break
+        }
+    }
+    close $fp
+    if {[string length $word] != 4 * $in_parallel} {
+        error "$f has [string length $word]-digit words, nn_pkg.sv IN_PARALLEL = $in_parallel needs [expr {4 * $in_parallel}]"
+    }
+    lappend mem_files $f
+}
+
+# Weight banks of the dataflow engines: one file per DF_L<k>_PARALLEL lane
+# of layer k, one weight per word. Required whatever DATAFLOW selects, so
+# both cores always elaborate with the bitstream model.
+for {set k 0} {$k < 3} {incr k} {
+    if {![regexp "parameter int DF_L${k}_PARALLEL\\s*=\\s*(\\d+)" $pkg_src -> df_lanes]} {
+        error "DF_L${k}_PARALLEL not found in nn_pkg.sv"
+    }
+    for {set l 0} {$l < $df_lanes} {incr l} {
+        set f [file join $mem_dir "nn_model_weights_df_l${k}_lane$l.mem"]
+        if {![file exists $f]} {
+            error "Missing $f: run python/train.py with df_lanes matching DF_L*_PARALLEL"
+        }
+        lappend mem_files $f
+    }
+}
+
+# The table of the selected activation must exist, or its ROM synthesizes
+# empty (ACT_HARD_SIGMOID and ACT_RELU need neither)
+if {![regexp {parameter int ACTIVATION\s*=\s*(\w+)} $pkg_src -> activation]} {
+    error "ACTIVATION not found in nn_pkg.sv"
+}
+set act_tables [dict create ACT_SIGMOID_LUT sigmoid_lut.mem ACT_SIGMOID_INTERP sigmoid_interp.mem]
+if {[dict exists $act_tables $activation]} {
+    set f [file join $mem_dir [dict get $act_tables $activation]]
+    if {![file exists $f]} {
+        error "Missing $f for $activation: run python/train.py"
+    }
+}
+
 foreach f $mem_files {
     if {[file exists $f]} {
         add_files -norecurse $f
@@ -124,13 +193,18 @@ create_bd_cell -type module -reference nn_accelerator nn_accelerator_0
 # Add AXI Interconnect
 puts "  Adding AXI Interconnect..."
 create_bd_cell -type ip -vlnv xilinx.com:ip:axi_interconnect:2.1 axi_interconnect_0
-set_property -dict [list CONFIG.NUM_MI {1}] [get_bd_cells axi_interconnect_0]
+set_property -dict [list CONFIG.NUM_MI {2}] [get_bd_cells axi_interconnect_0]
+
+# Add AXI Interconnect for DMA memory traffic (SG + MM2S + S2MM -> HP0)
+create_bd_cell -type ip -vlnv xilinx.com:ip:axi_interconnect:2.1 axi_mem_intercon
+set_property -dict [list CONFIG.NUM_SI {3} CONFIG.NUM_MI {1}] [get_bd_cells axi_mem_intercon]
 
-# Add AXI DMA (optional, for AXI-Stream data)
+# Add AXI DMA (scatter-gather, for AXI-Stream data)
 puts "  Adding AXI DMA..."
 create_bd_cell -type ip -vlnv xilinx.com:ip:axi_dma:7.1 axi_dma_0
 set_property -dict [list \
-    CONFIG.c_include_sg {0} \
+    CONFIG.c_include_sg {1} \
+    CONFIG.c_sg_length_width {23} \
     CONFIG.c_sg_include_stscntrl_strm {0} \
     CONFIG.c_m_axi_mm2s_data_width {32} \
     CONFIG.c_m_axis_mm2s_tdata_width {32} \
@@ -148,12 +222,24 @@ connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
     [get_bd_pins axi_interconnect_0/S00_ACLK]
 connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
     [get_bd_pins axi_interconnect_0/M00_ACLK]
+connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
+    [get_bd_pins axi_interconnect_0/M01_ACLK]
+connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
+    [get_bd_pins processing_system7_0/M_AXI_GP0_ACLK]
+connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
+    [get_bd_pins processing_system7_0/S_AXI_HP0_ACLK]
+foreach pin {ACLK S00_ACLK S01_ACLK S02_ACLK M00_ACLK} {
+    connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
+        [get_bd_pins axi_mem_intercon/$pin]
+}
 connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
     [get_bd_pins axi_dma_0/s_axi_lite_aclk]
 connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
     [get_bd_pins axi_dma_0/m_axi_mm2s_aclk]
 connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
     [get_bd_pins axi_dma_0/m_axi_s2mm_aclk]
+connect_bd_net [get_bd_pins processing_system7_0/FCLK_CLK0] \
+    [get_bd_pins axi_dma_0/m_axi_sg_aclk]
 
 # Connect resets
 puts "  Connecting resets..."
@@ -165,6 +251,12 @@ connect_bd_net [get_bd_pins processing_system7_0/FCLK_RESET0_N] \
     [get_bd_pins axi_interconnect_0/S00_ARESETN]
 connect_bd_net [get_bd_pins processing_system7_0/FCLK_RESET0_N] \
     [get_bd_pins axi_interconnect_0/M00_ARESETN]
+connect_bd_net [get_bd_pins processing_system7_0/FCLK_RESET0_N] \
+    [get_bd_pins axi_interconnect_0/M01_ARESETN]
+foreach pin {ARESETN S00_ARESETN S01_ARESETN S02_ARESETN M00_ARESETN} {
+    connect_bd_net [get_bd_pins processing_system7_0/FCLK_RESET0_N] \
+        [get_bd_pins axi_mem_intercon/$pin]
+}
 connect_bd_net [get_bd_pins processing_system7_0/FCLK_RESET0_N] \
     [get_bd_pins axi_dma_0/axi_resetn]
 
@@ -174,6 +266,18 @@ connect_bd_intf_net [get_bd_intf_pins processing_system7_0/M_AXI_GP0] \
     [get_bd_intf_pins axi_interconnect_0/S00_AXI]
 connect_bd_intf_net [get_bd_intf_pins axi_interconnect_0/M00_AXI] \
     [get_bd_intf_pins nn_accelerator_0/s_axi]
+connect_bd_intf_net [get_bd_intf_pins axi_interconnect_0/M01_AXI] \
+    [get_bd_intf_pins axi_dma_0/S_AXI_LITE]
+
+# Connect DMA memory masters to DDR through HP0
+connect_bd_intf_net [get_bd_intf_pins axi_dma_0/M_AXI_MM2S] \
+    [get_bd_intf_pins axi_mem_intercon/S00_AXI]
+connect_bd_intf_net [get_bd_intf_pins axi_dma_0/M_AXI_S2MM] \
+    [get_bd_intf_pins axi_mem_intercon/S01_AXI]
+connect_bd_intf_net [get_bd_intf_pins axi_dma_0/M_AXI_SG] \
+    [get_bd_intf_pins axi_mem_intercon/S02_AXI]
+connect_bd_intf_net [get_bd_intf_pins axi_mem_intercon/M00_AXI] \
+    [get_bd_intf_pins processing_system7_0/S_AXI_HP0]
 
 # Connect DMA to NN Accelerator AXI-Stream
 connect_bd_intf_net [get_bd_intf_pins axi_dma_0/M_AXIS_MM2S] \
@@ -184,11 +288,13 @@ connect_bd_intf_net [get_bd_intf_pins nn_accelerator_0/m_axis] \
 # Connect interrupt
 puts "  Connecting interrupt..."
 create_bd_cell -type ip -vlnv xilinx.com:ip:xlconcat:2.1 xlconcat_0
-set_property -dict [list CONFIG.NUM_PORTS {2}] [get_bd_cells xlconcat_0]
+set_property -dict [list CONFIG.NUM_PORTS {3}] [get_bd_cells xlconcat_0]
 connect_bd_net [get_bd_pins nn_accelerator_0/interrupt] \
     [get_bd_pins xlconcat_0/In0]
 connect_bd_net [get_bd_pins axi_dma_0/mm2s_introut] \
     [get_bd_pins xlconcat_0/In1]
+connect_bd_net [get_bd_pins axi_dma_0/s2mm_introut] \
+    [get_bd_pins xlconcat_0/In2]
 connect_bd_net [get_bd_pins xlconcat_0/dout] \
     [get_bd_pins processing_system7_0/IRQ_F2P]
 
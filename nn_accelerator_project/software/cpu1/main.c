@@ -0,0 +1,20 @@
+/**
+ * @file main.c
+ * @brief CPU1 application for the dual-core split (see nn_amp.h)
+ *
+ * Build as a second standalone application for ps7_cortexa9_1, linked at
+ * NN_AMP_CPU1_ENTRY, with ../nn_driver.c, ../nn_dma.c, ../nn_buf.c,
+ * ../nn_stats.c and ../nn_amp.c. Add -DUSE_AMP=1 to the BSP compiler
+ * flags so CPU1 leaves the L2 cache and the SCU to CPU0. Neither
+ * application may place anything in the NN_AMP_FRAMES_ADDR window.
+ */
+
+#include "nn_amp.h"
+
+int main(void)
+{
+    /* Owns the accelerator until CPU0 calls NN_AmpStop() */
+    NN_AmpFeederRun();
+
+    return 0;
+}
@@ -0,0 +1,555 @@
+/**
+ * @file nn_uio.c
+ * @brief Linux userspace driver implementation (UIO + udmabuf)
+ */
+
+#define _GNU_SOURCE
+#include "nn_uio_priv.h"
+#include "nn_stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*==============================================================================
+ * Register Access
+ * One load or store on the mapping; the mock branch is never taken on
+ * hardware.
+ *============================================================================*/
+
+static inline uint32_t nn_rd(const NN_Uio *dev, uint32_t offset)
+{
+    return dev->regs[offset >> 2];
+}
+
+static inline void nn_wr(NN_Uio *dev, uint32_t offset, uint32_t value)
+{
+    dev->regs[offset >> 2] = value;
+    if (dev->mock) {
+        NN_UioMockWrite(dev->mock, 0, offset, value);
+    }
+}
+
+static inline uint32_t nn_dma_rd(const NN_Uio *dev, uint32_t offset)
+{
+    return dev->dma[offset >> 2];
+}
+
+static inline void nn_dma_wr(NN_Uio *dev, uint32_t offset, uint32_t value)
+{
+    dev->dma[offset >> 2] = value;
+    if (dev->mock) {
+        NN_UioMockWrite(dev->mock, 1, offset, value);
+    }
+}
+
+/*==============================================================================
+ * Local Helpers
+ *============================================================================*/
+
+static int nn_sysfs_u64(const char *path, uint64_t *value)
+{
+    char line[64];
+    FILE *f = fopen(path, "r");
+
+    if (f == NULL) {
+        return -1;
+    }
+    if (fgets(line, sizeof(line), f) == NULL) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    *value = strtoull(line, NULL, 0);
+    return 0;
+}
+
+/* Find /dev/uioN whose sysfs name matches, and the size of its map0 */
+static int nn_find_uio(const char *name, char *dev_path, size_t len,
+                       size_t *map_size)
+{
+    char path[128];
+    char line[64];
+    uint64_t size;
+
+    for (int i = 0; i < 64; i++) {
+        FILE *f;
+
+        snprintf(path, sizeof(path), "/sys/class/uio/uio%d/name", i);
+        f = fopen(path, "r");
+        if (f == NULL) {
+            continue;
+        }
+        if (fgets(line, sizeof(line), f) == NULL) {
+            line[0] = '\0';
+        }
+        fclose(f);
+        line[strcspn(line, "\n")] = '\0';
+
+        if (strcmp(line, name) != 0) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "/sys/class/uio/uio%d/maps/map0/size", i);
+        if (nn_sysfs_u64(path, &size) < 0) {
+            return -1;
+        }
+        snprintf(dev_path, len, "/dev/uio%d", i);
+        *map_size = (size_t)size;
+        return 0;
+    }
+
+    errno = ENODEV;
+    return -1;
+}
+
+static int nn_map_uio(const char *name, int *fd, volatile uint32_t **base,
+                      size_t *size)
+{
+    char dev_path[32];
+    void *p;
+
+    if (nn_find_uio(name, dev_path, sizeof(dev_path), size) < 0) {
+        return -1;
+    }
+
+    *fd = open(dev_path, O_RDWR | O_CLOEXEC);
+    if (*fd < 0) {
+        return -1;
+    }
+
+    /* map0 is at offset 0 * page size */
+    p = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+    if (p == MAP_FAILED) {
+        close(*fd);
+        *fd = -1;
+        return -1;
+    }
+
+    *base = (volatile uint32_t *)p;
+    return 0;
+}
+
+static int nn_map_udmabuf(NN_Uio *dev, const char *name)
+{
+    static const char *const classes[] = { "u-dma-buf", "udmabuf" };
+    char path[128];
+    uint64_t phys = 0, size = 0;
+    int found = 0;
+    void *p;
+
+    for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]) && !found; i++) {
+        snprintf(path, sizeof(path), "/sys/class/%s/%s/phys_addr", classes[i], name);
+        if (nn_sysfs_u64(path, &phys) < 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/sys/class/%s/%s/size", classes[i], name);
+        if (nn_sysfs_u64(path, &size) < 0) {
+            continue;
+        }
+        found = 1;
+    }
+    if (!found) {
+        errno = ENODEV;
+        return -1;
+    }
+    if (size < NN_UIO_BUF_BYTES) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    /* O_SYNC maps the buffer uncached: no cache maintenance syscalls */
+    snprintf(path, sizeof(path), "/dev/%s", name);
+    dev->buf_fd = open(path, O_RDWR | O_SYNC | O_CLOEXEC);
+    if (dev->buf_fd < 0) {
+        return -1;
+    }
+
+    p = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, dev->buf_fd, 0);
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+
+    dev->buf      = (uint8_t *)p;
+    dev->buf_phys = phys;
+    dev->buf_size = (size_t)size;
+    return 0;
+}
+
+static inline volatile NN_UioBd *nn_bd(const NN_Uio *dev, uint32_t ring_off,
+                                       uint32_t slot)
+{
+    return (volatile NN_UioBd *)(dev->buf + ring_off + slot * NN_UIO_BD_BYTES);
+}
+
+static inline uint32_t nn_phys(const NN_Uio *dev, uint32_t offset)
+{
+    return (uint32_t)(dev->buf_phys + offset);
+}
+
+static int nn_dma_reset(NN_Uio *dev)
+{
+    nn_dma_wr(dev, NN_DMA_MM2S_DMACR, NN_DMACR_RESET);
+    for (int i = 0; i < 100000; i++) {
+        if (!(nn_dma_rd(dev, NN_DMA_MM2S_DMACR) & NN_DMACR_RESET)) {
+            return 0;
+        }
+    }
+    errno = ETIMEDOUT;
+    return -1;
+}
+
+/* Link both rings into circles and start the channels; they stay idle
+ * until the first tail pointer write */
+static int nn_dma_init(NN_Uio *dev)
+{
+    if (nn_dma_reset(dev) < 0) {
+        return -1;
+    }
+    if (!(nn_dma_rd(dev, NN_DMA_MM2S_DMASR) & NN_DMASR_SG_INCLD)) {
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < NN_UIO_RING; i++) {
+        uint32_t next = (i + 1) % NN_UIO_RING;
+        volatile NN_UioBd *tx = nn_bd(dev, NN_UIO_TX_RING_OFF, i);
+        volatile NN_UioBd *rx = nn_bd(dev, NN_UIO_RX_RING_OFF, i);
+
+        memset((void *)tx, 0, NN_UIO_BD_BYTES);
+        memset((void *)rx, 0, NN_UIO_BD_BYTES);
+        tx->next = nn_phys(dev, NN_UIO_TX_RING_OFF + next * NN_UIO_BD_BYTES);
+        rx->next = nn_phys(dev, NN_UIO_RX_RING_OFF + next * NN_UIO_BD_BYTES);
+        tx->addr = nn_phys(dev, NN_UIO_IN_OFF + i * NN_UIO_IN_STRIDE);
+        rx->addr = nn_phys(dev, NN_UIO_OUT_OFF + i * NN_UIO_OUT_STRIDE);
+    }
+    __sync_synchronize();
+
+    nn_dma_wr(dev, NN_DMA_MM2S_CURDESC, nn_phys(dev, NN_UIO_TX_RING_OFF));
+    nn_dma_wr(dev, NN_DMA_S2MM_CURDESC, nn_phys(dev, NN_UIO_RX_RING_OFF));
+    nn_dma_wr(dev, NN_DMA_MM2S_DMACR, NN_DMACR_RS);
+    nn_dma_wr(dev, NN_DMA_S2MM_DMACR, NN_DMACR_RS);
+
+    dev->tx_head = 0;
+    dev->rx_head = 0;
+    return 0;
+}
+
+static void nn_irq_unmask(NN_Uio *dev)
+{
+    uint32_t one = 1;
+
+    if (dev->mock) {
+        NN_UioMockUnmask(dev->mock);
+        return;
+    }
+    if (write(dev->irq_fd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+        /* A failed unmask shows up as a timeout in nn_wait_irq() */
+    }
+}
+
+static int nn_wait_irq(NN_Uio *dev, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = dev->irq_fd, .events = POLLIN };
+    uint64_t events;
+    size_t len = dev->mock ? sizeof(uint64_t) : sizeof(uint32_t);
+
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return -1;
+    }
+    /* UIO returns a 32-bit event count, eventfd a 64-bit one */
+    return (read(dev->irq_fd, &events, len) == (ssize_t)len) ? 0 : -1;
+}
+
+static int nn_wait_bd(volatile NN_UioBd *bd, nn_ts_t deadline)
+{
+    uint32_t sts;
+
+    while (!((sts = bd->status) & NN_BD_STS_CMPLT)) {
+        if (NN_Now() >= deadline) {
+            return -1;
+        }
+    }
+    return (sts & NN_BD_STS_ERR_MASK) ? -1 : 0;
+}
+
+static void nn_set_irq_count(NN_Uio *dev, uint16_t count)
+{
+    if (count != dev->irq_count) {
+        dev->irq_count = count;
+        nn_wr(dev, NN_REG_IRQ_COUNT, count);
+    }
+}
+
+/*
+ * Queue count frames already packed into the ring slots starting at
+ * tx_head/rx_head, then wait for all of them. Batches run in stream mode,
+ * single frames with START.
+ */
+static int nn_run_frames(NN_Uio *dev, uint16_t num_inputs, uint16_t num_outputs,
+                         uint16_t count, int timeout_ms, NN_Trace *tr)
+{
+    nn_ts_t deadline = NN_Now() + (nn_ts_t)timeout_ms * (NN_TS_PER_SEC / 1000);
+    uint32_t tx_last = 0, rx_last = 0;
+    uint32_t pending;
+
+    for (uint16_t f = 0; f < count; f++) {
+        uint32_t ts = (dev->tx_head + f) % NN_UIO_RING;
+        uint32_t rs = (dev->rx_head + f) % NN_UIO_RING;
+        volatile NN_UioBd *tx = nn_bd(dev, NN_UIO_TX_RING_OFF, ts);
+        volatile NN_UioBd *rx = nn_bd(dev, NN_UIO_RX_RING_OFF, rs);
+
+        tx->ctrl   = (num_inputs * NN_UIO_BEAT_BYTES) | NN_BD_CTRL_SOF | NN_BD_CTRL_EOF;
+        tx->status = 0;
+        rx->ctrl   = num_outputs * NN_UIO_BEAT_BYTES;
+        rx->status = 0;
+        tx_last = ts;
+        rx_last = rs;
+    }
+
+    /* One interrupt for the whole group */
+    nn_set_irq_count(dev, count);
+    if (dev->wait == NN_UIO_WAIT_IRQ) {
+        nn_irq_unmask(dev);
+    }
+
+    if (count == 1) {
+        nn_wr(dev, NN_REG_CTRL, dev->ctrl | NN_CTRL_START);
+    } else {
+        nn_wr(dev, NN_REG_CTRL, dev->ctrl | NN_CTRL_STREAM);
+    }
+
+    /* Descriptors must be in memory before the tail pointer moves */
+    __sync_synchronize();
+    nn_dma_wr(dev, NN_DMA_S2MM_TAILDESC,
+              nn_phys(dev, NN_UIO_RX_RING_OFF + rx_last * NN_UIO_BD_BYTES));
+    nn_dma_wr(dev, NN_DMA_MM2S_TAILDESC,
+              nn_phys(dev, NN_UIO_TX_RING_OFF + tx_last * NN_UIO_BD_BYTES));
+    tr->t[NN_TS_DMA_IN_START] = NN_Now();
+
+    dev->tx_head = (tx_last + 1) % NN_UIO_RING;
+    dev->rx_head = (rx_last + 1) % NN_UIO_RING;
+
+    if (nn_wait_bd(nn_bd(dev, NN_UIO_TX_RING_OFF, tx_last), deadline) < 0) {
+        goto fail;
+    }
+    tr->t[NN_TS_DMA_IN_END] = NN_Now();
+
+    if (dev->wait == NN_UIO_WAIT_IRQ) {
+        int left = (int)((deadline - NN_Now()) / (NN_TS_PER_SEC / 1000));
+        if (nn_wait_irq(dev, left > 0 ? left : 0) < 0) {
+            goto fail;
+        }
+    } else {
+        while (nn_rd(dev, NN_REG_IRQ_STATUS) < count) {
+            if (NN_Now() >= deadline) {
+                goto fail;
+            }
+        }
+    }
+    tr->t[NN_TS_COMPUTE_DONE] = NN_Now();
+
+    if (nn_wait_bd(nn_bd(dev, NN_UIO_RX_RING_OFF, rx_last), deadline) < 0) {
+        goto fail;
+    }
+    tr->t[NN_TS_DMA_OUT_END] = NN_Now();
+
+    pending = nn_rd(dev, NN_REG_IRQ_STATUS);
+    nn_wr(dev, NN_REG_IRQ_STATUS, pending);
+    if (count != 1) {
+        nn_wr(dev, NN_REG_CTRL, dev->ctrl);
+    }
+    return 0;
+
+fail:
+    nn_wr(dev, NN_REG_CTRL, dev->ctrl);
+    nn_dma_init(dev);
+    return -1;
+}
+
+/*==============================================================================
+ * Function Implementations
+ *============================================================================*/
+
+int NN_UioInitCommon(NN_Uio *dev)
+{
+    dev->wait      = NN_UIO_WAIT_IRQ;
+    dev->irq_count = 0xFFFF;
+
+    if (nn_dma_init(dev) < 0) {
+        return -1;
+    }
+
+    /* Soft reset, then continuous mode so frames need no reset in between */
+    nn_wr(dev, NN_REG_CTRL, NN_CTRL_SOFT_RESET);
+    dev->ctrl = NN_CTRL_ENABLE | NN_CTRL_CONTINUOUS;
+    nn_wr(dev, NN_REG_CTRL, dev->ctrl);
+
+    /* Drop completions left over from a previous user */
+    nn_wr(dev, NN_REG_IRQ_STATUS, nn_rd(dev, NN_REG_IRQ_STATUS));
+    nn_set_irq_count(dev, 1);
+    return 0;
+}
+
+int NN_UioOpen(NN_Uio *dev, const char *acc_name, const char *dma_name,
+               const char *buf_name)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->irq_fd = dev->dma_fd = dev->buf_fd = -1;
+
+    if (nn_map_uio(acc_name, &dev->irq_fd, &dev->regs, &dev->regs_size) < 0 ||
+        nn_map_uio(dma_name, &dev->dma_fd, &dev->dma, &dev->dma_size) < 0 ||
+        nn_map_udmabuf(dev, buf_name) < 0 ||
+        NN_UioInitCommon(dev) < 0) {
+        int err = errno;
+        NN_UioClose(dev);
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+void NN_UioClose(NN_Uio *dev)
+{
+    if (dev->mock) {
+        NN_UioMockFree(dev->mock);
+        dev->mock = NULL;
+    } else {
+        if (dev->regs) {
+            munmap((void *)dev->regs, dev->regs_size);
+        }
+        if (dev->dma) {
+            munmap((void *)dev->dma, dev->dma_size);
+        }
+        if (dev->buf) {
+            munmap(dev->buf, dev->buf_size);
+        }
+        if (dev->irq_fd >= 0) {
+            close(dev->irq_fd);
+        }
+        if (dev->dma_fd >= 0) {
+            close(dev->dma_fd);
+        }
+        if (dev->buf_fd >= 0) {
+            close(dev->buf_fd);
+        }
+    }
+    memset(dev, 0, sizeof(*dev));
+    dev->irq_fd = dev->dma_fd = dev->buf_fd = -1;
+}
+
+void NN_UioConfigure(NN_Uio *dev, uint16_t num_in, uint16_t num_h1,
+                     uint16_t num_h2, uint16_t num_out)
+{
+    nn_wr(dev, NN_REG_NUM_IN,  num_in);
+    nn_wr(dev, NN_REG_NUM_H1,  num_h1);
+    nn_wr(dev, NN_REG_NUM_H2,  num_h2);
+    nn_wr(dev, NN_REG_NUM_OUT, num_out);
+}
+
+void NN_UioSetWait(NN_Uio *dev, NN_UioWait wait)
+{
+    dev->wait = wait;
+}
+
+int NN_UioRun(NN_Uio *dev, const int16_t *inputs, uint16_t num_inputs,
+              int16_t *outputs, uint16_t num_outputs, int timeout_ms)
+{
+    NN_Trace tr;
+    uint32_t *in;
+    const uint32_t *out;
+    uint32_t in_slot = dev->tx_head;
+    uint32_t out_slot = dev->rx_head;
+
+    tr.t[NN_TS_SUBMIT] = NN_Now();
+
+    if (num_inputs > NN_UIO_MAX_INPUTS || num_outputs > NN_UIO_MAX_OUTPUTS) {
+        return -1;
+    }
+
+    in = (uint32_t *)(dev->buf + NN_UIO_IN_OFF + in_slot * NN_UIO_IN_STRIDE);
+    for (uint16_t i = 0; i < num_inputs; i++) {
+        in[i] = (uint32_t)(int32_t)inputs[i];
+    }
+
+    if (nn_run_frames(dev, num_inputs, num_outputs, 1, timeout_ms, &tr) < 0) {
+        return -1;
+    }
+
+    out = (const uint32_t *)(dev->buf + NN_UIO_OUT_OFF + out_slot * NN_UIO_OUT_STRIDE);
+    for (uint16_t i = 0; i < num_outputs; i++) {
+        outputs[i] = (int16_t)(out[i] & 0xFFFF);
+    }
+
+    tr.t[NN_TS_COMPLETE] = NN_Now();
+    NN_StatsRecord(&tr);
+    return 0;
+}
+
+int NN_UioRunVec(NN_Uio *dev, const int16_t *const *inputs, uint16_t num_inputs,
+                 int16_t *const *outputs, uint16_t num_outputs, uint16_t count,
+                 int timeout_ms)
+{
+    NN_Trace tr;
+    uint32_t in_slot = dev->tx_head;
+    uint32_t out_slot = dev->rx_head;
+
+    tr.t[NN_TS_SUBMIT] = NN_Now();
+
+    if (num_inputs > NN_UIO_MAX_INPUTS || num_outputs > NN_UIO_MAX_OUTPUTS ||
+        count == 0 || count > NN_UIO_RING) {
+        return -1;
+    }
+
+    for (uint16_t f = 0; f < count; f++) {
+        uint32_t slot = (in_slot + f) % NN_UIO_RING;
+        uint32_t *in = (uint32_t *)(dev->buf + NN_UIO_IN_OFF + slot * NN_UIO_IN_STRIDE);
+        const int16_t *src = inputs[f];
+
+        for (uint16_t i = 0; i < num_inputs; i++) {
+            in[i] = (uint32_t)(int32_t)src[i];
+        }
+    }
+
+    if (nn_run_frames(dev, num_inputs, num_outputs, count, timeout_ms, &tr) < 0) {
+        return -1;
+    }
+
+    for (uint16_t f = 0; f < count; f++) {
+        uint32_t slot = (out_slot + f) % NN_UIO_RING;
+        const uint32_t *out = (const uint32_t *)(dev->buf + NN_UIO_OUT_OFF +
+                                                 slot * NN_UIO_OUT_STRIDE);
+        int16_t *dst = outputs[f];
+
+        for (uint16_t i = 0; i < num_outputs; i++) {
+            dst[i] = (int16_t)(out[i] & 0xFFFF);
+        }
+    }
+
+    return 0;
+}
+
+int NN_UioRunBatch(NN_Uio *dev, const int16_t *inputs, uint16_t num_inputs,
+                   int16_t *outputs, uint16_t num_outputs, uint16_t count,
+                   int timeout_ms)
+{
+    const int16_t *in[NN_UIO_RING];
+    int16_t *out[NN_UIO_RING];
+
+    if (count == 0 || count > NN_UIO_RING) {
+        return -1;
+    }
+
+    for (uint16_t f = 0; f < count; f++) {
+        in[f]  = &inputs[(size_t)f * num_inputs];
+        out[f] = &outputs[(size_t)f * num_outputs];
+    }
+
+    return NN_UioRunVec(dev, in, num_inputs, out, num_outputs, count, timeout_ms);
+}
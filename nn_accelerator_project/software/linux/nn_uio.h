@@ -0,0 +1,174 @@
+/**
+ * @file nn_uio.h
+ * @brief Linux userspace driver for the NN accelerator (UIO + udmabuf)
+ *
+ * The accelerator and axi_dma_0 register windows are mmap()ed from their
+ * UIO devices and accessed with plain loads and stores, so the data path
+ * needs no syscall per register access. DMA buffers and scatter-gather
+ * descriptors live in a u-dma-buf region. Completion is either a poll()
+ * on the accelerator's UIO fd or a spin on the mapped registers.
+ *
+ * NN_UioOpenMock() provides the same interface on any Linux host: the
+ * registers and buffer are ordinary memory, a software model stands in
+ * for the hardware and an eventfd stands in for the UIO interrupt.
+ */
+
+#ifndef NN_UIO_H
+#define NN_UIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "nn_regs.h"
+
+/*==============================================================================
+ * Configuration
+ *============================================================================*/
+#define NN_UIO_RING         64          /* Descriptors per DMA channel */
+#define NN_UIO_MAX_INPUTS   784
+#define NN_UIO_MAX_OUTPUTS  16
+#define NN_UIO_BEAT_BYTES   4           /* One S.4.11 value per 32-bit beat */
+
+/*==============================================================================
+ * Data Types
+ *============================================================================*/
+
+/** How NN_UioRun() waits for completion */
+typedef enum {
+    NN_UIO_WAIT_IRQ = 0,    /* poll() on the UIO fd (sleeps, 3 syscalls) */
+    NN_UIO_WAIT_SPIN        /* Spin on mapped registers (no syscalls) */
+} NN_UioWait;
+
+struct NN_UioMock;
+
+typedef struct {
+    volatile uint32_t *regs;        /* Accelerator AXI-Lite window */
+    volatile uint32_t *dma;         /* axi_dma_0 register window */
+    size_t             regs_size;
+    size_t             dma_size;
+    int                irq_fd;      /* Accelerator UIO fd (eventfd for mock) */
+    int                dma_fd;
+    int                buf_fd;
+
+    /* u-dma-buf region: descriptor rings, input frames, result blocks */
+    uint8_t           *buf;
+    uint64_t           buf_phys;
+    size_t             buf_size;
+
+    uint32_t           tx_head;     /* Next free descriptor per ring */
+    uint32_t           rx_head;
+
+    NN_UioWait         wait;
+    uint32_t           ctrl;        /* CTRL shadow (START never stored) */
+    uint16_t           irq_count;   /* IRQ_COUNT shadow */
+
+    struct NN_UioMock *mock;        /* Non-NULL for the mock device */
+} NN_Uio;
+
+/*==============================================================================
+ * Function Prototypes
+ *============================================================================*/
+
+/**
+ * @brief Open the accelerator on a real board
+ *
+ * @param dev Device handle to initialize
+ * @param acc_name UIO name of the accelerator (e.g. "nn_accelerator")
+ * @param dma_name UIO name of axi_dma_0 (e.g. "axi_dma")
+ * @param buf_name u-dma-buf device name (e.g. "udmabuf0")
+ * @return 0 on success, -1 on failure (errno set)
+ */
+int NN_UioOpen(NN_Uio *dev, const char *acc_name, const char *dma_name,
+               const char *buf_name);
+
+/**
+ * @brief Open a software model of the accelerator
+ * @param dev Device handle to initialize
+ * @return 0 on success, -1 on failure
+ */
+int NN_UioOpenMock(NN_Uio *dev);
+
+/**
+ * @brief Release all mappings and file descriptors
+ * @param dev Device handle
+ */
+void NN_UioClose(NN_Uio *dev);
+
+/**
+ * @brief Program the network topology
+ * @param dev Device handle
+ * @param num_in Number of inputs
+ * @param num_h1 Hidden layer 1 size
+ * @param num_h2 Hidden layer 2 size
+ * @param num_out Number of outputs
+ */
+void NN_UioConfigure(NN_Uio *dev, uint16_t num_in, uint16_t num_h1,
+                     uint16_t num_h2, uint16_t num_out);
+
+/**
+ * @brief Select how completions are waited for
+ * @param dev Device handle
+ * @param wait NN_UIO_WAIT_IRQ or NN_UIO_WAIT_SPIN
+ */
+void NN_UioSetWait(NN_Uio *dev, NN_UioWait wait);
+
+/**
+ * @brief Run one inference
+ * @param dev Device handle
+ * @param inputs Input data array (fixed-point)
+ * @param num_inputs Number of inputs (<= NN_UIO_MAX_INPUTS)
+ * @param outputs Output data array (fixed-point)
+ * @param num_outputs Number of outputs (<= NN_UIO_MAX_OUTPUTS)
+ * @param timeout_ms Timeout in milliseconds
+ * @return 0 on success, -1 on failure or timeout
+ */
+int NN_UioRun(NN_Uio *dev, const int16_t *inputs, uint16_t num_inputs,
+              int16_t *outputs, uint16_t num_outputs, int timeout_ms);
+
+/**
+ * @brief Run count inferences as one descriptor chain, one interrupt
+ * @param dev Device handle
+ * @param inputs count * num_inputs values, frame after frame
+ * @param num_inputs Number of inputs per frame
+ * @param outputs count * num_outputs values, frame after frame
+ * @param num_outputs Number of outputs per frame
+ * @param count Number of frames (1 to NN_UIO_RING)
+ * @param timeout_ms Timeout in milliseconds
+ * @return 0 on success, -1 on failure or timeout
+ */
+int NN_UioRunBatch(NN_Uio *dev, const int16_t *inputs, uint16_t num_inputs,
+                   int16_t *outputs, uint16_t num_outputs, uint16_t count,
+                   int timeout_ms);
+
+/**
+ * @brief NN_UioRunBatch() with one pointer per frame
+ *
+ * For callers whose frames are not contiguous (the submission queue, the
+ * dual-core split).
+ *
+ * @param dev Device handle
+ * @param inputs count input frames of num_inputs values
+ * @param num_inputs Number of inputs per frame
+ * @param outputs count output frames of num_outputs values
+ * @param num_outputs Number of outputs per frame
+ * @param count Number of frames (1 to NN_UIO_RING)
+ * @param timeout_ms Timeout in milliseconds
+ * @return 0 on success, -1 on failure or timeout
+ */
+int NN_UioRunVec(NN_Uio *dev, const int16_t *const *inputs, uint16_t num_inputs,
+                 int16_t *const *outputs, uint16_t num_outputs, uint16_t count,
+                 int timeout_ms);
+
+/**
+ * @brief Expected outputs of the mock device for one frame
+ *
+ * Output k is the saturated sum of every input j with j % num_outputs == k.
+ *
+ * @param inputs Input data array
+ * @param num_inputs Number of inputs
+ * @param outputs Output data array
+ * @param num_outputs Number of outputs
+ */
+void NN_UioMockReference(const int16_t *inputs, uint16_t num_inputs,
+                         int16_t *outputs, uint16_t num_outputs);
+
+#endif /* NN_UIO_H */
@@ -0,0 +1,457 @@
+/**
+ * @file nn_uio_bench.c
+ * @brief Latency and throughput check for the Linux userspace driver
+ *
+ * Usage: nn_uio_bench [--mock | ACC_UIO DMA_UIO UDMABUF] [-n N | -d SECONDS]
+ *                     [--spin] [-t THREADS] [-p]
+ *
+ * With --mock (the default) every result is checked against
+ * NN_UioMockReference(); on hardware the outputs are only printed.
+ * The single-frame run is the release benchmark: -n N frames or -d SECONDS,
+ * round robin over the test frames, reported with NN_StatsReport().
+ * -t runs a contention test: THREADS producers share the device, first
+ * through a mutex around NN_UioRun(), then through the submission queue.
+ * -p runs the dual-core split as two pinned threads: CPU0 converts raw
+ * 8-bit frames and classifies results, CPU1 only feeds the device, with an
+ * NN_Ring each way; compared against doing all three on one thread.
+ */
+
+#define _GNU_SOURCE
+#include "nn_uio.h"
+#include "nn_uio_queue.h"
+#include "nn_ring.h"
+#include "nn_stats.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*==============================================================================
+ * Configuration
+ *============================================================================*/
+#define NUM_INPUTS      784
+#define NUM_HIDDEN1     16
+#define NUM_HIDDEN2     16
+#define NUM_OUTPUTS     10
+#define BATCH_SIZE      32
+#define TIMEOUT_MS      1000
+#define MAX_THREADS     64
+#define SPLIT_SLOTS     32          /* Frames in flight, <= NN_RING_SIZE */
+#define SPLIT_FAILED    (1u << 31)
+
+/*==============================================================================
+ * Test Data
+ *============================================================================*/
+static int16_t g_inputs[BATCH_SIZE][NUM_INPUTS];
+static int16_t g_outputs[BATCH_SIZE][NUM_OUTPUTS];
+static uint8_t g_raw[BATCH_SIZE][NUM_INPUTS];      /* Camera-style pixels */
+
+static void fill_inputs(uint32_t seed)
+{
+    for (int f = 0; f < BATCH_SIZE; f++) {
+        for (int i = 0; i < NUM_INPUTS; i++) {
+            seed = seed * 1103515245u + 12345u;
+            /* Pixel-like values in [0, 1.0) S.4.11 */
+            g_inputs[f][i] = (int16_t)((seed >> 16) & 0x7FF);
+            g_raw[f][i] = (uint8_t)(seed >> 24);
+        }
+    }
+}
+
+static int check_frame(const int16_t *in, const int16_t *out)
+{
+    int16_t ref[NUM_OUTPUTS];
+
+    NN_UioMockReference(in, NUM_INPUTS, ref, NUM_OUTPUTS);
+    return memcmp(ref, out, sizeof(ref)) == 0 ? 0 : -1;
+}
+
+/*==============================================================================
+ * Contention Test
+ *============================================================================*/
+typedef struct {
+    pthread_t        thread;
+    int              id;
+    int              count;
+    int              check;
+    int              errors;
+    NN_Uio          *dev;           /* Mutex variant */
+    pthread_mutex_t *lock;
+    NN_UioQueue     *queue;         /* Queue variant */
+} Producer;
+
+static void *producer(void *arg)
+{
+    Producer *p = (Producer *)arg;
+    int16_t out[NUM_OUTPUTS];
+
+    for (int k = 0; k < p->count; k++) {
+        const int16_t *in = g_inputs[(p->id + k) % BATCH_SIZE];
+        int ret;
+
+        if (p->queue != NULL) {
+            ret = NN_UioInfer(p->queue, in, out);
+        } else {
+            pthread_mutex_lock(p->lock);
+            ret = NN_UioRun(p->dev, in, NUM_INPUTS, out, NUM_OUTPUTS, TIMEOUT_MS);
+            pthread_mutex_unlock(p->lock);
+        }
+
+        if (ret != 0 || (p->check && check_frame(in, out) != 0)) {
+            p->errors++;
+        }
+    }
+    return NULL;
+}
+
+static int run_contention(NN_Uio *dev, int threads, int iterations, int check)
+{
+    static Producer prod[MAX_THREADS];
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    NN_UioQueue *queue = NULL;
+    int errors = 0;
+    int per_thread = iterations / threads;
+
+    if (posix_memalign((void **)&queue, NN_UIO_CACHE_LINE, sizeof(*queue)) != 0) {
+        return 1;
+    }
+
+    printf("contention: %d producers x %d inferences\n", threads, per_thread);
+
+    for (int variant = 0; variant < 2; variant++) {
+        nn_ts_t t0, t1;
+
+        if (variant == 1 && NN_UioQueueStart(queue, dev, NUM_INPUTS, NUM_OUTPUTS,
+                                             TIMEOUT_MS) != 0) {
+            fprintf(stderr, "queue start failed\n");
+            errors++;
+            break;
+        }
+
+        t0 = NN_Now();
+        for (int i = 0; i < threads; i++) {
+            prod[i] = (Producer) {
+                .id = i, .count = per_thread, .check = check,
+                .dev = dev, .lock = &lock,
+                .queue = (variant == 1) ? queue : NULL
+            };
+            pthread_create(&prod[i].thread, NULL, producer, &prod[i]);
+        }
+        for (int i = 0; i < threads; i++) {
+            pthread_join(prod[i].thread, NULL);
+            errors += prod[i].errors;
+        }
+        t1 = NN_Now();
+
+        printf("  %-6s %.1f inferences/s", variant ? "queue:" : "mutex:",
+               per_thread * threads * (double)NN_TS_PER_SEC / (double)(t1 - t0));
+        if (variant == 1) {
+            NN_UioQueueStop(queue);
+            printf(", %.1f jobs/chain, %llu feeder wakeups",
+                   queue->chains ? (double)queue->jobs / (double)queue->chains : 0.0,
+                   (unsigned long long)queue->wakeups);
+        }
+        printf("\n");
+    }
+
+    free(queue);
+    return errors;
+}
+
+/*==============================================================================
+ * Dual-Core Split
+ *============================================================================*/
+typedef struct {
+    NN_Ring  req;                   /* CPU0 -> CPU1: slots to run */
+    NN_Ring  done;                  /* CPU1 -> CPU0: finished slots */
+    NN_Uio  *dev;
+    int      stop;
+    uint64_t chains;
+    int16_t  in[SPLIT_SLOTS][NUM_INPUTS];
+    int16_t  out[SPLIT_SLOTS][NUM_OUTPUTS];
+} Split;
+
+/* Preprocessing: 8-bit pixels to S.4.11 in [0, 1.0] */
+static void preprocess(const uint8_t *raw, int16_t *in)
+{
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        in[i] = (int16_t)((raw[i] * 2048 + 127) / 255);
+    }
+}
+
+/* Post-processing: argmax, plus the reference check on the mock */
+static int postprocess(const int16_t *in, const int16_t *out, int check)
+{
+    int best = 0;
+
+    for (int i = 1; i < NUM_OUTPUTS; i++) {
+        if (out[i] > out[best]) {
+            best = i;
+        }
+    }
+    return (check && check_frame(in, out) != 0) ? -1 : best;
+}
+
+static void pin_to_cpu(int cpu)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        printf("  cpu%d not available, thread not pinned\n", cpu);
+    }
+}
+
+/* CPU1: nothing but the device */
+static void *split_feeder(void *arg)
+{
+    Split *sp = (Split *)arg;
+    const int16_t *in[SPLIT_SLOTS];
+    int16_t *out[SPLIT_SLOTS];
+    uint32_t slot[SPLIT_SLOTS];
+
+    pin_to_cpu(1);
+
+    for (;;) {
+        uint16_t n = 0;
+        int ret;
+
+        while (n < SPLIT_SLOTS && NN_RingPop(&sp->req, &slot[n]) == 0) {
+            in[n]  = sp->in[slot[n]];
+            out[n] = sp->out[slot[n]];
+            n++;
+        }
+
+        if (n == 0) {
+            if (__atomic_load_n(&sp->stop, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+
+        ret = NN_UioRunVec(sp->dev, in, NUM_INPUTS, out, NUM_OUTPUTS, n, TIMEOUT_MS);
+        for (uint16_t f = 0; f < n; f++) {
+            /* At most SPLIT_SLOTS in flight: cannot be full */
+            NN_RingPush(&sp->done, slot[f] | (ret == 0 ? 0 : SPLIT_FAILED));
+        }
+        sp->chains++;
+    }
+    return NULL;
+}
+
+static int run_split(NN_Uio *dev, int iterations, int check)
+{
+    Split *sp = NULL;
+    pthread_t feeder;
+    uint32_t free_slot[SPLIT_SLOTS];
+    int n_free = SPLIT_SLOTS;
+    int submitted = 0, done = 0, errors = 0;
+    nn_ts_t t0, t1;
+
+    if (posix_memalign((void **)&sp, NN_RING_LINE, sizeof(*sp)) != 0) {
+        return 1;
+    }
+    memset(sp, 0, sizeof(*sp));
+    sp->dev = dev;
+    for (int i = 0; i < SPLIT_SLOTS; i++) {
+        free_slot[i] = (uint32_t)i;
+    }
+
+    printf("split: %d frames, %ld CPUs online\n", iterations,
+           sysconf(_SC_NPROCESSORS_ONLN));
+    pin_to_cpu(0);
+
+    /* Baseline: preprocess, run and classify on one thread */
+    t0 = NN_Now();
+    for (int it = 0; it < iterations; it++) {
+        preprocess(g_raw[it % BATCH_SIZE], sp->in[0]);
+        if (NN_UioRun(dev, sp->in[0], NUM_INPUTS, sp->out[0], NUM_OUTPUTS,
+                      TIMEOUT_MS) != 0 ||
+            postprocess(sp->in[0], sp->out[0], check) < 0) {
+            errors++;
+        }
+    }
+    t1 = NN_Now();
+    printf("  one thread: %.1f inferences/s\n",
+           iterations * (double)NN_TS_PER_SEC / (double)(t1 - t0));
+
+    if (pthread_create(&feeder, NULL, split_feeder, sp) != 0) {
+        free(sp);
+        return errors + 1;
+    }
+
+    t0 = NN_Now();
+    while (done < iterations) {
+        uint32_t slot;
+
+        /* Keep every free slot queued */
+        while (submitted < iterations && n_free > 0) {
+            slot = free_slot[--n_free];
+            preprocess(g_raw[submitted % BATCH_SIZE], sp->in[slot]);
+            NN_RingPush(&sp->req, slot);
+            submitted++;
+        }
+
+        while (NN_RingPop(&sp->done, &slot) == 0) {
+            if ((slot & SPLIT_FAILED) ||
+                postprocess(sp->in[slot], sp->out[slot], check) < 0) {
+                errors++;
+            }
+            free_slot[n_free++] = slot & ~SPLIT_FAILED;
+            done++;
+        }
+
+        if (n_free == 0) {
+            sched_yield();
+        }
+    }
+    t1 = NN_Now();
+
+    __atomic_store_n(&sp->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(feeder, NULL);
+
+    printf("  split:      %.1f inferences/s, %.1f frames/chain\n",
+           iterations * (double)NN_TS_PER_SEC / (double)(t1 - t0),
+           sp->chains ? (double)iterations / (double)sp->chains : 0.0);
+
+    free(sp);
+    return errors;
+}
+
+/*==============================================================================
+ * Main
+ *============================================================================*/
+int main(int argc, char **argv)
+{
+    NN_Uio dev;
+    const char *names[3] = { NULL, NULL, NULL };
+    int n_names = 0;
+    int iterations = 1000;
+    int seconds = 0;
+    int spin = 0;
+    int threads = 0;
+    int split = 0;
+    int errors = 0;
+    uint32_t single = 0;
+    int is_mock;
+    nn_ts_t t0, t1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mock") == 0) {
+            n_names = 0;
+        } else if (strcmp(argv[i], "--spin") == 0) {
+            spin = 1;
+        } else if (strcmp(argv[i], "-p") == 0) {
+            split = 1;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (n_names < 3) {
+            names[n_names++] = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [--mock | ACC DMA BUF] [-n N | -d SECONDS] [--spin] [-t THREADS] [-p]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    is_mock = (n_names == 0);
+    if ((!is_mock && n_names != 3) || threads < 0 || threads > MAX_THREADS ||
+        seconds < 0) {
+        fprintf(stderr, "usage: %s [--mock | ACC DMA BUF] [-n N | -d SECONDS] [--spin] [-t THREADS] [-p]\n", argv[0]);
+        return 2;
+    }
+
+    if (is_mock ? NN_UioOpenMock(&dev) : NN_UioOpen(&dev, names[0], names[1], names[2])) {
+        fprintf(stderr, "open failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    NN_UioConfigure(&dev, NUM_INPUTS, NUM_HIDDEN1, NUM_HIDDEN2, NUM_OUTPUTS);
+    NN_UioSetWait(&dev, spin ? NN_UIO_WAIT_SPIN : NN_UIO_WAIT_IRQ);
+    fill_inputs(1);
+
+    if (seconds > 0) {
+        printf("%s device, %s completion, %d s\n",
+               is_mock ? "mock" : "UIO", spin ? "spin" : "poll()", seconds);
+    } else {
+        printf("%s device, %s completion, %d iterations\n",
+               is_mock ? "mock" : "UIO", spin ? "spin" : "poll()", iterations);
+    }
+
+    /* Single-frame latency, for a count or a duration */
+    NN_StatsReset();
+    t0 = t1 = NN_Now();
+    for (int it = 0; seconds > 0 ?
+         t1 - t0 < (nn_ts_t)seconds * NN_TS_PER_SEC : it < iterations; it++) {
+        int f = it % BATCH_SIZE;
+
+        if (NN_UioRun(&dev, g_inputs[f], NUM_INPUTS, g_outputs[f], NUM_OUTPUTS,
+                      TIMEOUT_MS) != 0) {
+            fprintf(stderr, "run %d timed out\n", it);
+            errors++;
+            break;
+        }
+        if (is_mock && check_frame(g_inputs[f], g_outputs[f]) != 0) {
+            fprintf(stderr, "run %d: output mismatch\n", it);
+            errors++;
+        }
+        single++;
+        t1 = NN_Now();
+    }
+    NN_StatsReport(single, t1 - t0);
+    iterations = single;
+
+    /* Batched throughput: one descriptor chain and one interrupt per batch */
+    t0 = NN_Now();
+    for (int it = 0; it < iterations / BATCH_SIZE; it++) {
+        if (NN_UioRunBatch(&dev, &g_inputs[0][0], NUM_INPUTS, &g_outputs[0][0],
+                           NUM_OUTPUTS, BATCH_SIZE, TIMEOUT_MS) != 0) {
+            fprintf(stderr, "batch %d timed out\n", it);
+            errors++;
+            break;
+        }
+        for (int f = 0; is_mock && f < BATCH_SIZE; f++) {
+            if (check_frame(g_inputs[f], g_outputs[f]) != 0) {
+                fprintf(stderr, "batch %d frame %d: output mismatch\n", it, f);
+                errors++;
+            }
+        }
+    }
+    t1 = NN_Now();
+    if (iterations >= BATCH_SIZE) {
+        printf("batch:  %.1f inferences/s\n",
+               (iterations / BATCH_SIZE) * BATCH_SIZE * (double)NN_TS_PER_SEC /
+               (double)(t1 - t0));
+    }
+
+    if (!is_mock) {
+        printf("outputs:");
+        for (int i = 0; i < NUM_OUTPUTS; i++) {
+            printf(" %d", g_outputs[0][i]);
+        }
+        printf("\n");
+    }
+
+    if (threads > 0) {
+        errors += run_contention(&dev, threads, iterations, is_mock);
+    }
+
+    if (split) {
+        errors += run_split(&dev, iterations, is_mock);
+    }
+
+    NN_StatsDump();
+    NN_UioClose(&dev);
+
+    printf("%s (%d errors)\n", errors ? "FAILED" : "PASSED", errors);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,306 @@
+/**
+ * @file nn_uio_mock.c
+ * @brief Software model of the accelerator and axi_dma_0 for NN_UioOpenMock()
+ *
+ * Register windows and the DMA buffer are ordinary memory. Every store the
+ * driver makes is followed by NN_UioMockWrite(), which applies the side
+ * effects the hardware would: descriptor processing, DONE, the coalesced
+ * completion count and the interrupt, signalled through an eventfd. The
+ * model completes work synchronously inside the store that triggers it.
+ */
+
+#define _GNU_SOURCE
+#include "nn_uio_priv.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/*==============================================================================
+ * Configuration
+ *============================================================================*/
+#define NN_MOCK_PHYS        0x30000000u /* Pretend bus address of the buffer */
+#define NN_MOCK_BUF_BYTES   (256 * 1024)
+#define NN_MOCK_REGS        16
+
+/*==============================================================================
+ * Data Types
+ *============================================================================*/
+struct NN_UioMock {
+    volatile uint32_t regs[NN_MOCK_REGS];
+    volatile uint32_t dma[NN_DMA_WINDOW / 4];
+    uint8_t          *buf;
+    int               efd;
+
+    uint32_t          tx_cur;       /* Next descriptor index per channel */
+    uint32_t          tx_tail;
+    uint32_t          rx_cur;
+    uint32_t          rx_tail;
+    int               tx_busy;
+    int               rx_busy;
+
+    int               start_pending;
+    uint32_t          pending;      /* Completions not yet acknowledged */
+    int               irq_enabled;  /* UIO semantics: masked after firing */
+};
+
+/*==============================================================================
+ * Local Helpers
+ *============================================================================*/
+
+static inline uint32_t nn_reg(const struct NN_UioMock *m, uint32_t offset)
+{
+    return m->regs[offset >> 2];
+}
+
+static inline volatile NN_UioBd *nn_mock_bd(struct NN_UioMock *m,
+                                            uint32_t ring_off, uint32_t idx)
+{
+    return (volatile NN_UioBd *)(m->buf + ring_off + idx * NN_UIO_BD_BYTES);
+}
+
+static uint32_t nn_bd_index(uint32_t phys, uint32_t ring_off)
+{
+    return (phys - NN_MOCK_PHYS - ring_off) / NN_UIO_BD_BYTES;
+}
+
+static void nn_mock_irq(struct NN_UioMock *m)
+{
+    uint32_t threshold = nn_reg(m, NN_REG_IRQ_COUNT);
+    uint64_t one = 1;
+
+    if (threshold == 0) {
+        threshold = 1;
+    }
+    if (m->irq_enabled && m->pending >= threshold) {
+        m->irq_enabled = 0;
+        if (write(m->efd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+            /* The driver sees a timeout */
+        }
+    }
+}
+
+/* Consume one input frame and produce one result block */
+static void nn_mock_frame(struct NN_UioMock *m)
+{
+    volatile NN_UioBd *tx = nn_mock_bd(m, NN_UIO_TX_RING_OFF, m->tx_cur);
+    volatile NN_UioBd *rx = nn_mock_bd(m, NN_UIO_RX_RING_OFF, m->rx_cur);
+    uint32_t in_len = tx->ctrl & NN_BD_CTRL_LEN_MASK;
+    uint16_t n_in = (uint16_t)(in_len / NN_UIO_BEAT_BYTES);
+    uint16_t n_out = (uint16_t)nn_reg(m, NN_REG_NUM_OUT);
+    const uint32_t *src = (const uint32_t *)(m->buf + (tx->addr - NN_MOCK_PHYS));
+    uint32_t *dst = (uint32_t *)(m->buf + (rx->addr - NN_MOCK_PHYS));
+    int16_t in[NN_UIO_MAX_INPUTS];
+    int16_t out[NN_UIO_MAX_OUTPUTS];
+    uint32_t best = 0;
+    int32_t second = -32768;
+    uint32_t margin;
+
+    if (n_in > NN_UIO_MAX_INPUTS) {
+        n_in = NN_UIO_MAX_INPUTS;
+    }
+    if (n_out > NN_UIO_MAX_OUTPUTS) {
+        n_out = NN_UIO_MAX_OUTPUTS;
+    }
+
+    for (uint16_t i = 0; i < n_in; i++) {
+        in[i] = (int16_t)(src[i] & 0xFFFF);
+    }
+    NN_UioMockReference(in, n_in, out, n_out);
+    for (uint16_t i = 0; i < n_out; i++) {
+        dst[i] = (uint32_t)(int32_t)out[i];
+        if (out[i] > out[best]) {
+            second = out[best];
+            best = i;
+        } else if (i != best && out[i] > second) {
+            second = out[i];
+        }
+    }
+    margin = n_out ? (uint32_t)(out[best] - second) & 0xFFFF : 0;
+
+    tx->status = NN_BD_STS_CMPLT | in_len;
+    rx->status = NN_BD_STS_CMPLT | (uint32_t)(n_out * NN_UIO_BEAT_BYTES);
+
+    m->tx_busy = (m->tx_cur != m->tx_tail);
+    m->rx_busy = (m->rx_cur != m->rx_tail);
+    m->tx_cur = nn_bd_index(tx->next, NN_UIO_TX_RING_OFF);
+    m->rx_cur = nn_bd_index(rx->next, NN_UIO_RX_RING_OFF);
+
+    m->regs[NN_REG_STATUS >> 2] = NN_STAT_DONE | (NN_STATE_DONE << NN_STAT_STATE_SHIFT) |
+                                  ((best << NN_STAT_CLASS_SHIFT) & NN_STAT_CLASS_MASK) |
+                                  (margin << NN_STAT_MARGIN_SHIFT);
+    m->regs[NN_REG_SCORE >> 2] = (margin << NN_SCORE_MARGIN_SHIFT) |
+                                 (n_out ? (uint16_t)out[best] : 0);
+    m->pending++;
+    m->regs[NN_REG_IRQ_STATUS >> 2] = m->pending;
+}
+
+/* Run frames while both channels have descriptors and the core may start */
+static void nn_mock_step(struct NN_UioMock *m)
+{
+    uint32_t ctrl = nn_reg(m, NN_REG_CTRL);
+
+    while ((ctrl & NN_CTRL_ENABLE) && m->tx_busy && m->rx_busy &&
+           (m->start_pending || (ctrl & NN_CTRL_STREAM))) {
+        m->start_pending = 0;
+        nn_mock_frame(m);
+    }
+
+    m->dma[NN_DMA_MM2S_DMASR >> 2] = NN_DMASR_SG_INCLD | (m->tx_busy ? 0 : NN_DMASR_IDLE);
+    m->dma[NN_DMA_S2MM_DMASR >> 2] = NN_DMASR_SG_INCLD | (m->rx_busy ? 0 : NN_DMASR_IDLE);
+    nn_mock_irq(m);
+}
+
+static void nn_mock_acc_write(struct NN_UioMock *m, uint32_t offset, uint32_t value)
+{
+    switch (offset) {
+    case NN_REG_CTRL:
+        if (value & NN_CTRL_SOFT_RESET) {
+            m->start_pending = 0;
+            m->regs[NN_REG_STATUS >> 2] = 0;
+        }
+        if (value & NN_CTRL_START) {
+            m->start_pending = 1;
+        }
+        m->regs[NN_REG_CTRL >> 2] = value & ~(uint32_t)NN_CTRL_START;
+        break;
+
+    case NN_REG_STATUS:
+        /* Read-only */
+        break;
+
+    case NN_REG_IRQ_STATUS:
+        m->pending -= (value < m->pending) ? value : m->pending;
+        m->regs[NN_REG_IRQ_STATUS >> 2] = m->pending;
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void nn_mock_dma_write(struct NN_UioMock *m, uint32_t offset, uint32_t value)
+{
+    switch (offset) {
+    case NN_DMA_MM2S_DMACR:
+    case NN_DMA_S2MM_DMACR:
+        if (value & NN_DMACR_RESET) {
+            /* Either reset bit resets both channels, and self-clears */
+            memset((void *)m->dma, 0, sizeof(m->dma));
+            m->tx_busy = m->rx_busy = 0;
+        }
+        break;
+
+    case NN_DMA_MM2S_CURDESC:
+        m->tx_cur = nn_bd_index(value, NN_UIO_TX_RING_OFF);
+        break;
+
+    case NN_DMA_S2MM_CURDESC:
+        m->rx_cur = nn_bd_index(value, NN_UIO_RX_RING_OFF);
+        break;
+
+    case NN_DMA_MM2S_TAILDESC:
+        if (m->dma[NN_DMA_MM2S_DMACR >> 2] & NN_DMACR_RS) {
+            m->tx_tail = nn_bd_index(value, NN_UIO_TX_RING_OFF);
+            m->tx_busy = 1;
+        }
+        break;
+
+    case NN_DMA_S2MM_TAILDESC:
+        if (m->dma[NN_DMA_S2MM_DMACR >> 2] & NN_DMACR_RS) {
+            m->rx_tail = nn_bd_index(value, NN_UIO_RX_RING_OFF);
+            m->rx_busy = 1;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*==============================================================================
+ * Function Implementations
+ *============================================================================*/
+
+void NN_UioMockWrite(struct NN_UioMock *mock, int space, uint32_t offset,
+                     uint32_t value)
+{
+    if (space == 0) {
+        nn_mock_acc_write(mock, offset, value);
+    } else {
+        nn_mock_dma_write(mock, offset, value);
+    }
+    nn_mock_step(mock);
+}
+
+void NN_UioMockUnmask(struct NN_UioMock *mock)
+{
+    mock->irq_enabled = 1;
+    nn_mock_irq(mock);
+}
+
+void NN_UioMockFree(struct NN_UioMock *mock)
+{
+    if (mock->efd >= 0) {
+        close(mock->efd);
+    }
+    free(mock->buf);
+    free(mock);
+}
+
+int NN_UioOpenMock(NN_Uio *dev)
+{
+    struct NN_UioMock *m;
+
+    memset(dev, 0, sizeof(*dev));
+    dev->irq_fd = dev->dma_fd = dev->buf_fd = -1;
+
+    m = calloc(1, sizeof(*m));
+    if (m == NULL) {
+        return -1;
+    }
+    m->efd = eventfd(0, EFD_CLOEXEC);
+    if (m->efd < 0 ||
+        posix_memalign((void **)&m->buf, 4096, NN_MOCK_BUF_BYTES) != 0) {
+        NN_UioMockFree(m);
+        return -1;
+    }
+    memset(m->buf, 0, NN_MOCK_BUF_BYTES);
+    m->dma[NN_DMA_MM2S_DMASR >> 2] = NN_DMASR_SG_INCLD | NN_DMASR_HALTED;
+    m->dma[NN_DMA_S2MM_DMASR >> 2] = NN_DMASR_SG_INCLD | NN_DMASR_HALTED;
+
+    dev->mock      = m;
+    dev->regs      = m->regs;
+    dev->dma       = m->dma;
+    dev->regs_size = sizeof(m->regs);
+    dev->dma_size  = sizeof(m->dma);
+    dev->irq_fd    = m->efd;
+    dev->buf       = m->buf;
+    dev->buf_phys  = NN_MOCK_PHYS;
+    dev->buf_size  = NN_MOCK_BUF_BYTES;
+
+    if (NN_UioInitCommon(dev) < 0) {
+        NN_UioClose(dev);
+        return -1;
+    }
+    return 0;
+}
+
+void NN_UioMockReference(const int16_t *inputs, uint16_t num_inputs,
+                         int16_t *outputs, uint16_t num_outputs)
+{
+    for (uint16_t k = 0; k < num_outputs; k++) {
+        int32_t sum = 0;
+
+        for (uint16_t j = k; j < num_inputs; j += num_outputs) {
+            sum += inputs[j];
+            if (sum > INT16_MAX) {
+                sum = INT16_MAX;
+            } else if (sum < INT16_MIN) {
+                sum = INT16_MIN;
+            }
+        }
+        outputs[k] = (int16_t)sum;
+    }
+}
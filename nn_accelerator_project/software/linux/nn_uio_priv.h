@@ -0,0 +1,80 @@
+/**
+ * @file nn_uio_priv.h
+ * @brief Internal definitions shared by nn_uio.c and nn_uio_mock.c
+ */
+
+#ifndef NN_UIO_PRIV_H
+#define NN_UIO_PRIV_H
+
+#include "nn_uio.h"
+
+/*==============================================================================
+ * AXI DMA Registers (PG021, scatter-gather mode)
+ *============================================================================*/
+#define NN_DMA_MM2S_DMACR       0x00
+#define NN_DMA_MM2S_DMASR       0x04
+#define NN_DMA_MM2S_CURDESC     0x08
+#define NN_DMA_MM2S_TAILDESC    0x10
+#define NN_DMA_S2MM_DMACR       0x30
+#define NN_DMA_S2MM_DMASR       0x34
+#define NN_DMA_S2MM_CURDESC     0x38
+#define NN_DMA_S2MM_TAILDESC    0x40
+#define NN_DMA_WINDOW           0x100
+
+#define NN_DMACR_RS             (1u << 0)   /* Run/stop */
+#define NN_DMACR_RESET          (1u << 2)   /* Soft reset (self-clearing) */
+
+#define NN_DMASR_HALTED         (1u << 0)
+#define NN_DMASR_IDLE           (1u << 1)
+#define NN_DMASR_SG_INCLD       (1u << 3)   /* Built with scatter-gather */
+
+/*==============================================================================
+ * Scatter-Gather Descriptor
+ *============================================================================*/
+#define NN_BD_CTRL_LEN_MASK     0x03FFFFFFu
+#define NN_BD_CTRL_SOF          (1u << 27)
+#define NN_BD_CTRL_EOF          (1u << 26)
+#define NN_BD_STS_CMPLT         (1u << 31)
+#define NN_BD_STS_ERR_MASK      (7u << 28)  /* Int / slave / decode error */
+#define NN_BD_STS_LEN_MASK      0x03FFFFFFu
+
+typedef struct {
+    uint32_t next;
+    uint32_t next_msb;
+    uint32_t addr;
+    uint32_t addr_msb;
+    uint32_t rsvd[2];
+    uint32_t ctrl;
+    uint32_t status;
+    uint32_t app[5];
+    uint32_t pad[3];            /* Descriptors are 64-byte aligned */
+} NN_UioBd;
+
+/*==============================================================================
+ * u-dma-buf Layout
+ *   [TX ring][RX ring][input frame x RING][result block x RING]
+ *============================================================================*/
+#define NN_UIO_BD_BYTES         sizeof(NN_UioBd)
+#define NN_UIO_TX_RING_OFF      0
+#define NN_UIO_RX_RING_OFF      (NN_UIO_RING * NN_UIO_BD_BYTES)
+#define NN_UIO_IN_OFF           (2 * NN_UIO_RING * NN_UIO_BD_BYTES)
+#define NN_UIO_IN_STRIDE        (NN_UIO_MAX_INPUTS * NN_UIO_BEAT_BYTES)
+#define NN_UIO_OUT_OFF          (NN_UIO_IN_OFF + NN_UIO_RING * NN_UIO_IN_STRIDE)
+#define NN_UIO_OUT_STRIDE       (NN_UIO_MAX_OUTPUTS * NN_UIO_BEAT_BYTES)
+#define NN_UIO_BUF_BYTES        (NN_UIO_OUT_OFF + NN_UIO_RING * NN_UIO_OUT_STRIDE)
+
+/*==============================================================================
+ * Internal Functions
+ *============================================================================*/
+
+/* Common bring-up once the windows, IRQ fd and buffer are in place */
+int NN_UioInitCommon(NN_Uio *dev);
+
+/* Mock hooks: a register store has been made to regs (space 0) or dma
+ * (space 1); the mock applies its side effects */
+void NN_UioMockWrite(struct NN_UioMock *mock, int space, uint32_t offset,
+                     uint32_t value);
+void NN_UioMockUnmask(struct NN_UioMock *mock);
+void NN_UioMockFree(struct NN_UioMock *mock);
+
+#endif /* NN_UIO_PRIV_H */
@@ -0,0 +1,264 @@
+/**
+ * @file nn_uio_queue.c
+ * @brief Lock-free multi-producer submission queue implementation
+ */
+
+#define _GNU_SOURCE
+#include "nn_uio_queue.h"
+#include "nn_uio_priv.h"
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*==============================================================================
+ * Configuration
+ *============================================================================*/
+#define NN_QUEUE_MASK       (NN_UIO_QUEUE_SIZE - 1)
+#define NN_FEEDER_SPIN      2000        /* Empty polls before the feeder sleeps */
+#define NN_WAITER_SPIN      200         /* State polls before a waiter sleeps */
+
+/*==============================================================================
+ * Local Helpers
+ *============================================================================*/
+
+static inline void nn_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline void nn_futex_wait(int *addr, int val)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static inline void nn_futex_wake(int *addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+/* Consumer side: no read-modify-write, the feeder owns head */
+static NN_UioJob *nn_dequeue(NN_UioQueue *q)
+{
+    NN_UioCell *cell = &q->cells[q->head & NN_QUEUE_MASK];
+    NN_UioJob *job;
+
+    if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != q->head + 1) {
+        return NULL;
+    }
+
+    job = cell->job;
+    /* Hand the cell back to producers one lap ahead */
+    __atomic_store_n(&cell->seq, q->head + NN_UIO_QUEUE_SIZE, __ATOMIC_RELEASE);
+    q->head++;
+    return job;
+}
+
+static int nn_queue_ready(NN_UioQueue *q)
+{
+    const NN_UioCell *cell = &q->cells[q->head & NN_QUEUE_MASK];
+
+    return __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) == q->head + 1;
+}
+
+static void nn_complete(NN_UioJob **jobs, uint16_t count, int state)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        /* Only submitters that went to sleep cost a syscall */
+        if (__atomic_exchange_n(&jobs[i]->state, state, __ATOMIC_ACQ_REL) ==
+            NN_JOB_SLEEPING) {
+            nn_futex_wake(&jobs[i]->state);
+        }
+    }
+}
+
+/* Block until a producer publishes a job or the queue is stopped */
+static void nn_feeder_idle(NN_UioQueue *q)
+{
+    uint64_t events;
+
+    for (int i = 0; i < NN_FEEDER_SPIN; i++) {
+        if (nn_queue_ready(q) || __atomic_load_n(&q->stop, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+        nn_cpu_relax();
+    }
+
+    /* Announce the sleep, then re-check: a producer that published before
+     * seeing the flag is caught here, one after it writes wake_fd */
+    __atomic_store_n(&q->sleeping, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (nn_queue_ready(q) || __atomic_load_n(&q->stop, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&q->sleeping, 0, __ATOMIC_SEQ_CST);
+        return;
+    }
+
+    if (read(q->wake_fd, &events, sizeof(events)) == (ssize_t)sizeof(events)) {
+        q->wakeups++;
+    }
+}
+
+static void *nn_feeder(void *arg)
+{
+    NN_UioQueue *q = (NN_UioQueue *)arg;
+    NN_UioJob *jobs[NN_UIO_RING];
+    const int16_t *in[NN_UIO_RING];
+    int16_t *out[NN_UIO_RING];
+
+    for (;;) {
+        uint16_t n = 0;
+
+        /* Everything already waiting goes out as one descriptor chain */
+        while (n < NN_UIO_RING && (jobs[n] = nn_dequeue(q)) != NULL) {
+            in[n]  = jobs[n]->inputs;
+            out[n] = jobs[n]->outputs;
+            n++;
+        }
+
+        if (n > 0) {
+            int ret = (n == 1) ?
+                NN_UioRun(q->dev, in[0], q->num_inputs, out[0],
+                          q->num_outputs, q->timeout_ms) :
+                NN_UioRunVec(q->dev, in, q->num_inputs, out,
+                             q->num_outputs, n, q->timeout_ms);
+
+            nn_complete(jobs, n, (ret == 0) ? NN_JOB_DONE : NN_JOB_FAILED);
+            q->jobs += n;
+            q->chains++;
+            continue;
+        }
+
+        /* Stop only once the queue is empty */
+        if (__atomic_load_n(&q->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        nn_feeder_idle(q);
+    }
+
+    return NULL;
+}
+
+/*==============================================================================
+ * Function Implementations
+ *============================================================================*/
+
+int NN_UioQueueStart(NN_UioQueue *q, NN_Uio *dev, uint16_t num_inputs,
+                     uint16_t num_outputs, int timeout_ms)
+{
+    memset(q, 0, sizeof(*q));
+    q->dev         = dev;
+    q->num_inputs  = num_inputs;
+    q->num_outputs = num_outputs;
+    q->timeout_ms  = timeout_ms;
+
+    for (size_t i = 0; i < NN_UIO_QUEUE_SIZE; i++) {
+        q->cells[i].seq = i;
+    }
+
+    q->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (q->wake_fd < 0) {
+        return -1;
+    }
+
+    if (pthread_create(&q->feeder, NULL, nn_feeder, q) != 0) {
+        close(q->wake_fd);
+        return -1;
+    }
+    return 0;
+}
+
+void NN_UioQueueStop(NN_UioQueue *q)
+{
+    uint64_t one = 1;
+
+    __atomic_store_n(&q->stop, 1, __ATOMIC_SEQ_CST);
+    if (write(q->wake_fd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+        /* The feeder re-checks stop before every sleep */
+    }
+    pthread_join(q->feeder, NULL);
+    close(q->wake_fd);
+}
+
+int NN_UioSubmit(NN_UioQueue *q, NN_UioJob *job)
+{
+    size_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    NN_UioCell *cell;
+    uint64_t one = 1;
+
+    for (;;) {
+        intptr_t diff;
+
+        cell = &q->cells[pos & NN_QUEUE_MASK];
+        diff = (intptr_t)__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (intptr_t)pos;
+
+        if (diff == 0) {
+            /* Cell free for this lap: claim it */
+            if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* The feeder has not consumed the previous lap yet */
+            errno = EAGAIN;
+            return -1;
+        } else {
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    job->state = NN_JOB_QUEUED;
+    cell->job  = job;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+    /* Pairs with the fence in nn_feeder_idle() */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->sleeping, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&q->sleeping, 0, __ATOMIC_SEQ_CST)) {
+        if (write(q->wake_fd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+            /* eventfd writes of 1 only fail on counter overflow */
+        }
+    }
+    return 0;
+}
+
+int NN_UioJobWait(NN_UioJob *job)
+{
+    int state;
+
+    for (int i = 0; i < NN_WAITER_SPIN; i++) {
+        state = __atomic_load_n(&job->state, __ATOMIC_ACQUIRE);
+        if (state != NN_JOB_QUEUED) {
+            return (state == NN_JOB_DONE) ? 0 : -1;
+        }
+        nn_cpu_relax();
+    }
+
+    /* Tell the feeder a wake-up is needed; fails if the job just finished */
+    state = NN_JOB_QUEUED;
+    if (__atomic_compare_exchange_n(&job->state, &state, NN_JOB_SLEEPING, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        while ((state = __atomic_load_n(&job->state, __ATOMIC_ACQUIRE)) ==
+               NN_JOB_SLEEPING) {
+            nn_futex_wait(&job->state, NN_JOB_SLEEPING);
+        }
+    }
+    return (state == NN_JOB_DONE) ? 0 : -1;
+}
+
+int NN_UioInfer(NN_UioQueue *q, const int16_t *inputs, int16_t *outputs)
+{
+    NN_UioJob job = { .inputs = inputs, .outputs = outputs };
+
+    while (NN_UioSubmit(q, &job) < 0) {
+        sched_yield();
+    }
+    return NN_UioJobWait(&job);
+}
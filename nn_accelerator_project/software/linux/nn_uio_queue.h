@@ -0,0 +1,130 @@
+/**
+ * @file nn_uio_queue.h
+ * @brief Lock-free multi-producer submission queue for the Linux driver
+ *
+ * Any number of threads submit jobs without taking a lock; one feeder
+ * thread owns the NN_Uio device (registers, DMA rings, interrupt) and
+ * drains the queue, running whatever is waiting as one descriptor chain.
+ * Each job is its own completion handle: the submitting thread waits on
+ * it (futex) while other producers keep submitting.
+ *
+ * The queue is a bounded array of sequence-numbered cells (Vyukov): a
+ * producer claims a slot with one compare-and-swap on the tail and
+ * publishes it by bumping the cell's sequence number. The single consumer
+ * needs no atomic read-modify-write at all.
+ */
+
+#ifndef NN_UIO_QUEUE_H
+#define NN_UIO_QUEUE_H
+
+#include <pthread.h>
+#include "nn_uio.h"
+
+/*==============================================================================
+ * Configuration
+ *============================================================================*/
+#define NN_UIO_QUEUE_SIZE   256         /* Cells, power of two */
+#define NN_UIO_CACHE_LINE   64          /* Keeps the two indices apart */
+
+/*==============================================================================
+ * Data Types
+ *============================================================================*/
+
+/** Job state, also the futex word the submitter sleeps on */
+typedef enum {
+    NN_JOB_QUEUED = 0,
+    NN_JOB_SLEEPING,            /* Queued, submitter blocked in futex */
+    NN_JOB_DONE,
+    NN_JOB_FAILED
+} NN_JobState;
+
+/**
+ * One inference request. Owned by the submitter; must stay valid until
+ * NN_UioJobWait() returns. All jobs in one queue share the topology set
+ * with NN_UioConfigure() before NN_UioQueueStart().
+ */
+typedef struct {
+    const int16_t *inputs;
+    int16_t       *outputs;
+    int            state;       /* NN_JobState, accessed atomically */
+} NN_UioJob;
+
+typedef struct {
+    size_t     seq;
+    NN_UioJob *job;
+} NN_UioCell;
+
+typedef struct {
+    NN_Uio    *dev;
+    uint16_t   num_inputs;
+    uint16_t   num_outputs;
+    int        timeout_ms;
+
+    /* Producers: claimed with CAS */
+    size_t     tail __attribute__((aligned(NN_UIO_CACHE_LINE)));
+    /* Feeder only */
+    size_t     head __attribute__((aligned(NN_UIO_CACHE_LINE)));
+
+    int        sleeping;        /* Feeder is (about to be) blocked */
+    int        stop;
+    int        wake_fd;         /* eventfd: producer -> idle feeder */
+    pthread_t  feeder;
+
+    /* Feeder statistics */
+    uint64_t   jobs;
+    uint64_t   chains;          /* Descriptor chains run */
+    uint64_t   wakeups;         /* Times the feeder had to be woken */
+
+    NN_UioCell cells[NN_UIO_QUEUE_SIZE] __attribute__((aligned(NN_UIO_CACHE_LINE)));
+} NN_UioQueue;
+
+/*==============================================================================
+ * Function Prototypes
+ *============================================================================*/
+
+/**
+ * @brief Start the feeder thread
+ *
+ * From here on only the feeder may touch dev, until NN_UioQueueStop().
+ *
+ * @param q Queue to initialize
+ * @param dev Open and configured device
+ * @param num_inputs Number of inputs per job
+ * @param num_outputs Number of outputs per job
+ * @param timeout_ms Timeout per descriptor chain
+ * @return 0 on success, -1 on failure
+ */
+int NN_UioQueueStart(NN_UioQueue *q, NN_Uio *dev, uint16_t num_inputs,
+                     uint16_t num_outputs, int timeout_ms);
+
+/**
+ * @brief Drain outstanding jobs and stop the feeder thread
+ * @param q Queue
+ */
+void NN_UioQueueStop(NN_UioQueue *q);
+
+/**
+ * @brief Submit a job without blocking (safe from any thread)
+ * @param q Queue
+ * @param job Job with inputs and outputs filled in
+ * @return 0 on success, -1 if the queue is full (errno EAGAIN)
+ */
+int NN_UioSubmit(NN_UioQueue *q, NN_UioJob *job);
+
+/**
+ * @brief Wait for a submitted job to finish
+ * @param job Job passed to NN_UioSubmit()
+ * @return 0 on success, -1 if the inference failed
+ */
+int NN_UioJobWait(NN_UioJob *job);
+
+/**
+ * @brief Submit (retrying while full) and wait: a thread-safe NN_UioRun()
+ * @param q Queue
+ * @param inputs Input data array (fixed-point)
+ * @param outputs Output data array (fixed-point)
+ * @return 0 on success, -1 on failure
+ */
+int NN_UioInfer(NN_UioQueue *q, const int16_t *inputs, int16_t *outputs);
+
+#endif /* NN_UIO_QUEUE_H */
@@ -7,18 +7,52 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "platform.h"
 #include "xil_printf.h"
 #include "xil_cache.h"
 #include "xparameters.h"
 #include "nn_driver.h"
+#include "nn_buf.h"
+#include "nn_stats.h"
 #include "test_images.h"
 
+/* Set to 1 and add mem/nn_weights.h to the application sources to run
+ * the model upload test */
+#ifndef MODEL_UPLOAD_TEST
+#define MODEL_UPLOAD_TEST 0
+#endif
+
+#if MODEL_UPLOAD_TEST
+#include "nn_weights.h"
+#endif
+
+/* Set to 1 for the release benchmark: every test image, round robin, for
+ * BENCH_SECONDS (or BENCH_COUNT inferences if non-zero), instead of the
+ * demo */
+#ifndef BENCH_MODE
+#define BENCH_MODE 0
+#endif
+
+/* Set to 1 to run as CPU0 of the dual-core split: this core packs and
+ * classifies, the application in cpu1/ feeds the accelerator */
+#ifndef DUAL_CORE
+#define DUAL_CORE 0
+#endif
+
+#if DUAL_CORE
+#include "nn_amp.h"
+#endif
+
 /*==============================================================================
  * Configuration
  *============================================================================*/
 #define NUM_TESTS       10      /* Number of test images (one per digit) */
-#define TIMEOUT_US      5000000 /* 5 second timeout */
+#define PIPE_REPEAT     4       /* Passes over the test images, pipelined */
+#define BENCH_SECONDS   10      /* Benchmark duration */
+#define BENCH_COUNT     0       /* Benchmark inferences (0 = use duration) */
+#define AMP_FRAMES      1000    /* Frames through the dual-core split */
+#define AMP_STALL_MS    1000    /* No result for this long: CPU1 is gone */
 
 /*==============================================================================
  * Function Prototypes
@@ -26,6 +60,24 @@
 static void print_banner(void);
 static void print_results(int correct, int total);
 static int run_single_test(int digit, s16 *outputs);
+static void print_timing(void);
+static void run_batch_test(void);
+static void on_complete(u32 count, void *ref);
+static void run_cache_bench(void);
+static void run_pipeline_test(void);
+static void run_fast_test(void);
+static void print_pipeline(const NN_PipeReport *r);
+static void print_mmio(int images);
+static void print_watchdog(void);
+#if MODEL_UPLOAD_TEST
+static void run_model_test(void);
+#endif
+#if BENCH_MODE
+static void run_benchmark(void);
+#endif
+#if DUAL_CORE
+static void run_dual_core(void);
+#endif
 
 /*==============================================================================
  * Main Function
@@ -44,6 +96,12 @@ int main(void)
     /* Print banner */
     print_banner();
     
+#if DUAL_CORE
+    /* CPU1 owns the accelerator; this core never touches the driver */
+    run_dual_core();
+    goto cleanup;
+#endif
+    
     /* Initialize NN accelerator */
     xil_printf("Initializing NN Accelerator...\r\n");
     if (NN_Init(NULL) < 0) {
@@ -54,6 +112,14 @@ int main(void)
     xil_printf("  Network: 784 -> 16 -> 16 -> 10\r\n");
     xil_printf("  Fixed-point: S.4.11 (16-bit)\r\n\r\n");
     
+    /* Back-to-back inferences, no soft reset between images */
+    NN_SetContinuous(1);
+    
+#if BENCH_MODE
+    run_benchmark();
+    goto cleanup;
+#endif
+    
     /* Get initial status */
     NN_GetStatus(&status);
     xil_printf("Status: Busy=%d, Done=%d, State=%d\r\n\r\n", 
@@ -63,6 +129,7 @@ int main(void)
     xil_printf("Running MNIST Classification Tests:\r\n");
     xil_printf("----------------------------------------\r\n");
     
+    NN_ClearMmioStats();
     for (int digit = 0; digit < NUM_TESTS; digit++) {
         xil_printf("Testing digit %d... ", digit);
         
@@ -92,16 +159,38 @@ int main(void)
             xil_printf("%d:%.2f ", i, FIXED_TO_FLOAT(outputs[i]));
         }
         xil_printf("\r\n");
-        
-        /* Reset for next test */
-        NN_Reset();
+        print_timing();
     }
     
     xil_printf("----------------------------------------\r\n\r\n");
     
+    print_mmio(NUM_TESTS);
+    NN_StatsDump();
+    xil_printf("\r\n");
+    
     /* Print final results */
     print_results(correct, NUM_TESTS);
     
+    /* All test images as one DMA batch */
+    run_batch_test();
+    
+    /* Transfer / compute / readback overlap */
+    run_pipeline_test();
+    
+    /* Class only: no result stream, argmax read from STATUS */
+    run_fast_test();
+    
+    /* Cache maintenance cost per image */
+    run_cache_bench();
+    
+    /* Hang detection limits and any recoveries so far */
+    print_watchdog();
+    
+#if MODEL_UPLOAD_TEST
+    /* Weight upload over DMA, then the hash-matched skip */
+    run_model_test();
+#endif
+    
 cleanup:
     /* Cleanup */
     xil_printf("\r\nDemo complete.\r\n");
@@ -144,41 +233,444 @@ static void print_results(int correct, int total)
 
 static int run_single_test(int digit, s16 *outputs)
 {
-    /* Get test image */
-    const s16 *image = get_test_image(digit);
+    NN_Buf *buf = NN_BufAlloc();
+    int ret;
     
-    /* Flush cache before DMA transfer */
-    Xil_DCacheFlush();
+    if (buf == NULL) {
+        return -1;
+    }
     
-    /* Start inference
-     * Note: In a full implementation, you would:
-     * 1. Configure DMA to transfer input image
-     * 2. Transfer weights and biases (if not pre-loaded)
-     * 3. Start the accelerator
-     * 4. Wait for completion
-     * 5. Read back outputs via DMA
-     *
-     * This simplified version demonstrates the driver API.
-     */
+    /* Pack the test image straight into a DMA-safe buffer */
+    NN_BufPack(buf, get_test_image(digit), IMAGE_SIZE);
     
-    /* Start accelerator */
-    NN_Start();
+    /* Stream image in over MM2S, compute, read results back over S2MM.
+     * Only the buffer's own cache lines are flushed/invalidated. */
+    ret = NN_RunInferenceBuf(buf, IMAGE_SIZE, 10);
+    if (ret == 0) {
+        NN_BufUnpack(buf, outputs, 10);
+    }
     
-    /* Wait for completion */
-    if (NN_WaitDone(TIMEOUT_US) < 0) {
-        return -1;
+    NN_BufFree(buf);
+    return ret;
+}
+
+static void on_complete(u32 count, void *ref)
+{
+    *(u32 *)ref += count;
+}
+
+static void run_batch_test(void)
+{
+    static s16 batch_in[NUM_TESTS * IMAGE_SIZE];
+    static s16 batch_out[NUM_TESTS * 10];
+    NN_Timing t;
+    int correct = 0;
+    u32 completed = 0;
+    
+    for (int digit = 0; digit < NUM_TESTS; digit++) {
+        memcpy(&batch_in[digit * IMAGE_SIZE], get_test_image(digit),
+               IMAGE_SIZE * sizeof(s16));
     }
     
-    /* Read outputs
-     * In full implementation, outputs would be read from 
-     * AXI-Stream master interface via DMA.
-     *
-     * For now, we use dummy values for demonstration.
-     */
-    for (int i = 0; i < 10; i++) {
-        /* Placeholder - replace with actual output reading */
-        outputs[i] = (i == digit) ? FLOAT_TO_FIXED(0.9f) : FLOAT_TO_FIXED(0.1f);
+    /* One interrupt for the whole batch; drop earlier completions first */
+    NN_SetCompletionHandler(NULL, NULL);
+    NN_IrqHandler(NULL);
+    NN_SetIrqCoalesce(NUM_TESTS, 1000000);
+    NN_SetCompletionHandler(on_complete, &completed);
+    
+    xil_printf("\r\nBatch of %d images...\r\n", NUM_TESTS);
+    if (NN_RunBatch(batch_in, IMAGE_SIZE, batch_out, 10, NUM_TESTS) < 0) {
+        xil_printf("  TIMEOUT\r\n");
+        return;
     }
     
-    return 0;
+    /* What the ISR would do on the single coalesced interrupt */
+    NN_IrqHandler(NULL);
+    NN_SetIrqCoalesce(0, 0);
+    xil_printf("  %d completions drained by one handler call\r\n", completed);
+    
+    for (int digit = 0; digit < NUM_TESTS; digit++) {
+        if (NN_Classify(&batch_out[digit * 10], 10) == digit) {
+            correct++;
+        }
+    }
+    
+    NN_GetLastTiming(&t);
+    xil_printf("  %d/%d correct, total=%d us, %d us/image\r\n",
+               correct, NUM_TESTS, NN_TICKS_TO_US(t.total),
+               NN_TICKS_TO_US(t.total) / NUM_TESTS);
+}
+
+static void run_pipeline_test(void)
+{
+    static s16 pipe_in[PIPE_REPEAT * NUM_TESTS * IMAGE_SIZE];
+    static s16 pipe_out[PIPE_REPEAT * NUM_TESTS * 10];
+    static NN_PipeReport report;
+    const u32 frames = PIPE_REPEAT * NUM_TESTS;
+    XTime t0, t1;
+    int correct = 0;
+    
+    for (u32 f = 0; f < frames; f++) {
+        memcpy(&pipe_in[f * IMAGE_SIZE], get_test_image(f % NUM_TESTS),
+               IMAGE_SIZE * sizeof(s16));
+    }
+    
+    xil_printf("\r\nPipeline, %d images:\r\n", frames);
+    
+    /* Reference: one image at a time, stages strictly in sequence */
+    XTime_GetTime(&t0);
+    for (u32 f = 0; f < frames; f++) {
+        NN_RunInference(&pipe_in[f * IMAGE_SIZE], IMAGE_SIZE,
+                        &pipe_out[f * 10], 10);
+    }
+    XTime_GetTime(&t1);
+    xil_printf("  sequential %d us/image\r\n", NN_TICKS_TO_US(t1 - t0) / frames);
+    
+    if (NN_RunPipelined(pipe_in, IMAGE_SIZE, pipe_out, 10, frames, &report) < 0) {
+        xil_printf("  TIMEOUT\r\n");
+        return;
+    }
+    
+    for (u32 f = 0; f < frames; f++) {
+        if (NN_Classify(&pipe_out[f * 10], 10) == (int)(f % NUM_TESTS)) {
+            correct++;
+        }
+    }
+    xil_printf("  pipelined  %d us/image, %d/%d correct\r\n",
+               NN_TICKS_TO_US(report.wall) / frames, correct, frames);
+    
+    print_pipeline(&report);
+}
+
+static void print_pipeline(const NN_PipeReport *r)
+{
+    u64 serial = r->host_in + r->device + r->host_out;
+    XTime base = r->trace[0].t[NN_TS_SUBMIT];
+    u32 shown = (r->frames < NN_PIPE_TRACE) ? r->frames : NN_PIPE_TRACE;
+    
+    if (r->wall == 0) {
+        return;
+    }
+    
+    /* overlap: 100% = stages back to back, 300% = all three always busy */
+    xil_printf("  host_in=%d device=%d host_out=%d wall=%d us, depth %d\r\n",
+               NN_TICKS_TO_US(r->host_in), NN_TICKS_TO_US(r->device),
+               NN_TICKS_TO_US(r->host_out), NN_TICKS_TO_US(r->wall), r->depth);
+    xil_printf("  overlap %d%%, accelerator busy %d%%\r\n",
+               (int)(serial * 100 / r->wall), (int)(r->device * 100 / r->wall));
+    
+    xil_printf("  frame    pack   queued  in_done  out_done  delivered (us)\r\n");
+    for (u32 f = 0; f < shown; f++) {
+        const NN_Trace *tr = &r->trace[f];
+        
+        xil_printf("  %5d %7d %8d %8d %9d %10d\r\n", f,
+                   NN_TICKS_TO_US(tr->t[NN_TS_SUBMIT] - base),
+                   NN_TICKS_TO_US(tr->t[NN_TS_DMA_IN_START] - base),
+                   NN_TICKS_TO_US(tr->t[NN_TS_DMA_IN_END] - base),
+                   NN_TICKS_TO_US(tr->t[NN_TS_DMA_OUT_END] - base),
+                   NN_TICKS_TO_US(tr->t[NN_TS_COMPLETE] - base));
+    }
+}
+
+static void run_fast_test(void)
+{
+    NN_Buf *buf;
+    NN_Timing t;
+    s16 outputs[10];
+    u64 full = 0, fast = 0;
+    int correct = 0, agree = 0;
+    s16 score;
+    u16 margin;
+    
+    xil_printf("\r\nClass-only fast path (%d images):\r\n", NUM_TESTS);
+    
+    for (int digit = 0; digit < NUM_TESTS; digit++) {
+        int full_class = -1, fast_class;
+        
+        buf = NN_BufAlloc();
+        if (buf == NULL) {
+            return;
+        }
+        NN_BufPack(buf, get_test_image(digit), IMAGE_SIZE);
+        
+        /* Full path: stream all outputs back, argmax in software */
+        if (NN_RunInferenceBuf(buf, IMAGE_SIZE, 10) == 0) {
+            NN_BufUnpack(buf, outputs, 10);
+            full_class = NN_Classify(outputs, 10);
+            NN_GetLastTiming(&t);
+            full += t.total;
+        }
+        
+        /* Same buffer, class only */
+        fast_class = NN_ClassifyBuf(buf, IMAGE_SIZE);
+        NN_GetLastTiming(&t);
+        fast += t.total;
+        NN_GetScore(&score, &margin);
+        NN_BufFree(buf);
+        
+        if (fast_class == digit) {
+            correct++;
+        }
+        /* Class and score must both match the streamed outputs */
+        if (full_class >= 0 && fast_class == full_class &&
+            score == outputs[full_class]) {
+            agree++;
+        }
+        xil_printf("  digit %d -> %d, score %d, margin %d\r\n",
+                   digit, fast_class, score, margin);
+    }
+    
+    xil_printf("  %d/%d correct, %d/%d match NN_Classify() and its score\r\n",
+               correct, NUM_TESTS, agree, NUM_TESTS);
+    xil_printf("  full=%d us/image, class-only=%d us/image\r\n",
+               NN_TICKS_TO_US(full) / NUM_TESTS,
+               NN_TICKS_TO_US(fast) / NUM_TESTS);
+}
+
+static void print_timing(void)
+{
+    NN_Timing t;
+    
+    NN_GetLastTiming(&t);
+    xil_printf("         Latency (us): pack=%d dma_in=%d compute=%d "
+               "dma_out=%d cache=%d total=%d\r\n",
+               NN_TICKS_TO_US(t.pack), NN_TICKS_TO_US(t.dma_in),
+               NN_TICKS_TO_US(t.compute), NN_TICKS_TO_US(t.dma_out),
+               NN_TICKS_TO_US(t.cache), NN_TICKS_TO_US(t.total));
+}
+
+static void run_cache_bench(void)
+{
+    static const char *names[] = { "full flush", "ranged", "non-cached" };
+    NN_Buf *buf;
+    XTime t0, t1;
+    u64 cost[3] = { 0, 0, 0 };
+    s16 outputs[10];
+    
+    xil_printf("\r\nCache maintenance per image (%d images):\r\n", NUM_TESTS);
+    
+    for (int m = 0; m < 3; m++) {
+        NN_BufPoolInit(m == 2 ? NN_BUF_NONCACHED : NN_BUF_CACHED);
+        
+        for (int digit = 0; digit < NUM_TESTS; digit++) {
+            buf = NN_BufAlloc();
+            NN_BufPack(buf, get_test_image(digit), IMAGE_SIZE);
+            
+            if (m == 0) {
+                /* Old behaviour: whole L1/L2 before every transfer */
+                XTime_GetTime(&t0);
+                Xil_DCacheFlush();
+                XTime_GetTime(&t1);
+                cost[m] += t1 - t0;
+            }
+            
+            if (NN_RunInferenceBuf(buf, IMAGE_SIZE, 10) == 0) {
+                NN_Timing t;
+                
+                NN_GetLastTiming(&t);
+                if (m != 0) {
+                    cost[m] += t.cache;
+                }
+                NN_BufUnpack(buf, outputs, 10);
+            }
+            NN_BufFree(buf);
+        }
+        
+        xil_printf("  %-10s %d us/image\r\n", names[m],
+                   NN_TICKS_TO_US(cost[m]) / NUM_TESTS);
+    }
+    
+    NN_BufPoolInit(NN_BUF_CACHED);
+}
+
+static void print_mmio(int images)
+{
+    static const char *names[NN_OP_COUNT] = {
+        "reset", "configure", "start", "mode", "status", "model", "irq"
+    };
+    NN_MmioStats m;
+    
+    NN_GetMmioStats(&m);
+    xil_printf("MMIO over %d images (reads/writes/skipped):\r\n", images);
+    for (int op = 0; op < NN_OP_COUNT; op++) {
+        xil_printf("  %-9s %d/%d/%d\r\n", names[op],
+                   m.reads[op], m.writes[op], m.skipped[op]);
+    }
+    xil_printf("\r\n");
+}
+
+static void print_watchdog(void)
+{
+    NN_WdStats wd;
+    
+    NN_GetWdStats(&wd);
+    xil_printf("\r\nWatchdog: expect %d us/frame, limit %d us\r\n",
+               wd.expected_us, wd.limit_us);
+    xil_printf("  hangs=%d resubmitted=%d failed=%d\r\n",
+               wd.hangs, wd.resubmits, wd.failures);
+}
+
+#if BENCH_MODE
+static void run_benchmark(void)
+{
+    NN_Buf *bufs[NUM_TEST_IMAGES];
+    s16 outputs[10];
+    const u32 count = BENCH_COUNT;
+    const XTime duration = (XTime)BENCH_SECONDS * COUNTS_PER_SECOND;
+    XTime t_start, now;
+    u32 frames = 0, errors = 0;
+    int n;
+    
+    /* Every test image packed once; the loop is driver + accelerator only */
+    for (n = 0; n < NUM_TEST_IMAGES; n++) {
+        bufs[n] = NN_BufAlloc();
+        if (bufs[n] == NULL) {
+            xil_printf("ERROR: buffer pool too small\r\n");
+            goto out;
+        }
+        NN_BufPack(bufs[n], get_test_image(n), IMAGE_SIZE);
+    }
+    
+    if (count > 0) {
+        xil_printf("Benchmark: %d inferences over %d images\r\n",
+                   count, NUM_TEST_IMAGES);
+    } else {
+        xil_printf("Benchmark: %d s over %d images\r\n",
+                   BENCH_SECONDS, NUM_TEST_IMAGES);
+    }
+    
+    NN_StatsReset();
+    XTime_GetTime(&t_start);
+    now = t_start;
+    
+    while (count > 0 ? frames < count : now - t_start < duration) {
+        int digit = frames % NUM_TEST_IMAGES;
+        
+        if (NN_RunInferenceBuf(bufs[digit], IMAGE_SIZE, 10) < 0) {
+            errors++;
+        } else {
+            NN_BufUnpack(bufs[digit], outputs, 10);
+            if (NN_Classify(outputs, 10) != digit) {
+                errors++;
+            }
+        }
+        frames++;
+        XTime_GetTime(&now);
+    }
+    
+    NN_StatsReport(frames, now - t_start);
+    xil_printf("  %d errors (timeouts or misclassified)\r\n", errors);
+    print_watchdog();
+    
+out:
+    while (n > 0) {
+        NN_BufFree(bufs[--n]);
+    }
+}
+#endif
+
+#if DUAL_CORE
+static void run_dual_core(void)
+{
+    u16 digit_of[NN_AMP_SLOTS];
+    s16 outputs[10];
+    NN_AmpStats st;
+    NN_Buf *buf;
+    XTime t_start, t_end, last;
+    u32 submitted = 0, done = 0, correct = 0, errors = 0;
+    int failed;
+    
+    xil_printf("Dual-core split: starting CPU1 feeder...\r\n");
+    if (NN_AmpInit(IMAGE_SIZE, 10) < 0) {
+        xil_printf("ERROR: CPU1 did not start (loaded at 0x%08X?)\r\n",
+                   NN_AMP_CPU1_ENTRY);
+        return;
+    }
+    
+    XTime_GetTime(&t_start);
+    last = t_start;
+    
+    while (done < AMP_FRAMES) {
+        XTime now;
+        
+        /* Preprocess: keep every free slot queued so CPU1 never waits */
+        while (submitted < AMP_FRAMES && (buf = NN_AmpAlloc()) != NULL) {
+            digit_of[buf->id] = submitted % NUM_TESTS;
+            NN_BufPack(buf, get_test_image(digit_of[buf->id]), IMAGE_SIZE);
+            if (NN_AmpSubmit(buf) < 0) {
+                NN_AmpFree(buf);
+                break;
+            }
+            submitted++;
+        }
+        
+        /* Post-process whatever CPU1 has handed back */
+        XTime_GetTime(&now);
+        while ((buf = NN_AmpCollect(&failed)) != NULL) {
+            if (failed) {
+                errors++;
+            } else {
+                NN_BufUnpack(buf, outputs, 10);
+                if (NN_Classify(outputs, 10) == digit_of[buf->id]) {
+                    correct++;
+                }
+            }
+            NN_AmpFree(buf);
+            done++;
+            last = now;
+        }
+        
+        if (now - last > (XTime)AMP_STALL_MS * (COUNTS_PER_SECOND / 1000)) {
+            xil_printf("ERROR: no results from CPU1 for %d ms\r\n", AMP_STALL_MS);
+            break;
+        }
+    }
+    XTime_GetTime(&t_end);
+    
+    NN_AmpStop();
+    NN_AmpGetStats(&st);
+    
+    xil_printf("  %d frames, %d correct, %d failed, %d us/frame\r\n",
+               done, correct, errors,
+               done ? NN_TICKS_TO_US(t_end - t_start) / done : 0);
+    xil_printf("  CPU1: %d chains, %d frames/chain\r\n", st.chains,
+               st.chains ? st.frames / st.chains : 0);
+}
+#endif
+
+#if MODEL_UPLOAD_TEST
+static void run_model_test(void)
+{
+    NN_Model model = {
+        .weights = { &WEIGHTS_L0[0][0], &WEIGHTS_L1[0][0], &WEIGHTS_L2[0][0] },
+        .biases  = { BIASES_L0, BIASES_L1, BIASES_L2 },
+        .sizes   = { 784, 16, 16, 10 }
+    };
+    XTime t0, t1;
+    s16 outputs[10];
+    s16 ref[10];
+    int ret;
+    
+    NN_ModelInit(&model);
+    xil_printf("\r\nModel upload (hash 0x%08X):\r\n", model.hash);
+    
+    for (int pass = 0; pass < 2; pass++) {
+        XTime_GetTime(&t0);
+        ret = NN_LoadModel(&model);
+        XTime_GetTime(&t1);
+        xil_printf("  %s in %d us\r\n",
+                   ret == 1 ? "skipped (resident)" : ret == 0 ? "uploaded" : "FAILED",
+                   NN_TICKS_TO_US(t1 - t0));
+    }
+    
+    if (run_single_test(0, outputs) == 0) {
+        xil_printf("  digit 0 -> %d\r\n", NN_Classify(outputs, 10));
+        
+        /* The CPU reference must reproduce the accelerator bit for bit */
+        if (NN_ModelReference(&model, get_test_image(0), ref) == 0) {
+            xil_printf("  CPU reference: %s\r\n",
+                       memcmp(ref, outputs, sizeof(ref)) == 0 ? "match" : "MISMATCH");
+        }
+    }
 }
+#endif
@@ -0,0 +1,212 @@
+/**
+ * @file nn_amp.c
+ * @brief Dual-core split implementation
+ */
+
+#include "nn_amp.h"
+#include "xil_cache.h"
+#include "xil_io.h"
+#include "xil_mmu.h"
+#include "xpseudo_asm.h"
+
+/*==============================================================================
+ * Module Variables
+ *============================================================================*/
+
+/* Slot data in the reserved DDR window; each frame is whole cache lines */
+typedef struct {
+    u32 in[NN_AMP_SLOTS][NN_MAX_INPUTS];
+    u32 out[NN_AMP_SLOTS][NN_MAX_OUTPUTS];
+} NN_AmpFrames;
+
+static NN_AmpShared *const g_sh = (NN_AmpShared *)NN_AMP_SHARED_ADDR;
+static NN_AmpFrames *const g_frames = (NN_AmpFrames *)NN_AMP_FRAMES_ADDR;
+
+/* Each core keeps its own NN_Buf views of the same slots */
+static NN_Buf g_slots[NN_AMP_SLOTS];
+
+/* CPU0 only */
+static u16 g_free[NN_AMP_SLOTS];
+static u16 g_free_count;
+
+/*==============================================================================
+ * Local Helpers
+ *============================================================================*/
+
+static void nn_amp_map(void)
+{
+    /* Rings and control words are shared uncached; no maintenance needed */
+    Xil_SetTlbAttributes(NN_AMP_SHARED_ADDR, NORM_NONCACHE);
+
+    for (u16 i = 0; i < NN_AMP_SLOTS; i++) {
+        g_slots[i].in  = g_frames->in[i];
+        g_slots[i].out = g_frames->out[i];
+        g_slots[i].id  = i;
+    }
+}
+
+/* Order the ring update before the event, then wake the other core */
+static inline void nn_amp_kick(void)
+{
+    dsb();
+    sev();
+}
+
+static int nn_amp_wait_ready(u32 want)
+{
+    XTime deadline;
+
+    XTime_GetTime(&deadline);
+    deadline += ((u64)NN_AMP_START_US * COUNTS_PER_SECOND) / 1000000ULL;
+
+    while (__atomic_load_n(&g_sh->ready, __ATOMIC_ACQUIRE) != want) {
+        if (NN_Expired(deadline)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*==============================================================================
+ * Function Implementations
+ *============================================================================*/
+
+int NN_AmpInit(u16 num_inputs, u16 num_outputs)
+{
+    if (num_inputs > NN_MAX_INPUTS || num_outputs > NN_MAX_OUTPUTS ||
+        NN_AMP_SLOTS > NN_MAX_BATCH || NN_AMP_SLOTS > NN_RING_SIZE) {
+        return -1;
+    }
+
+    nn_amp_map();
+
+    NN_RingInit(&g_sh->req);
+    NN_RingInit(&g_sh->done);
+    g_sh->num_inputs  = num_inputs;
+    g_sh->num_outputs = num_outputs;
+    g_sh->stop  = 0;
+    g_sh->ready = 0;
+    g_sh->stats = (NN_AmpStats) { 0 };
+
+    for (u16 i = 0; i < NN_AMP_SLOTS; i++) {
+        g_free[i] = NN_AMP_SLOTS - 1 - i;
+    }
+    g_free_count = NN_AMP_SLOTS;
+
+    /* The boot ROM holds CPU1 in WFE until it finds a start address here */
+    Xil_Out32(NN_AMP_CPU1_WAKE, NN_AMP_CPU1_ENTRY);
+    nn_amp_kick();
+
+    return nn_amp_wait_ready(1);
+}
+
+NN_Buf *NN_AmpAlloc(void)
+{
+    if (g_free_count == 0) {
+        return NULL;
+    }
+    return &g_slots[g_free[--g_free_count]];
+}
+
+void NN_AmpFree(NN_Buf *buf)
+{
+    if (buf != NULL && g_free_count < NN_AMP_SLOTS) {
+        g_free[g_free_count++] = buf->id;
+    }
+}
+
+int NN_AmpSubmit(NN_Buf *buf)
+{
+    /* The DMA reads DDR, so the packed beats must be out of L1 and L2 */
+    Xil_DCacheFlushRange((INTPTR)buf->in, g_sh->num_inputs * NN_AXIS_BEAT_BYTES);
+
+    if (NN_RingPush(&g_sh->req, buf->id) < 0) {
+        return -1;
+    }
+    nn_amp_kick();
+    return 0;
+}
+
+NN_Buf *NN_AmpCollect(int *failed)
+{
+    NN_Buf *buf;
+    u32 entry;
+
+    if (NN_RingPop(&g_sh->done, &entry) < 0) {
+        return NULL;
+    }
+
+    buf = &g_slots[(entry & ~NN_AMP_FAILED) % NN_AMP_SLOTS];
+    *failed = (entry & NN_AMP_FAILED) ? 1 : 0;
+
+    /* Drop any line CPU0 still holds from the slot's last use */
+    Xil_DCacheInvalidateRange((INTPTR)buf->out, g_sh->num_outputs * NN_AXIS_BEAT_BYTES);
+    return buf;
+}
+
+void NN_AmpStop(void)
+{
+    __atomic_store_n(&g_sh->stop, 1, __ATOMIC_RELEASE);
+    nn_amp_kick();
+
+    /* The feeder clears ready once the request ring is drained */
+    nn_amp_wait_ready(0);
+}
+
+void NN_AmpGetStats(NN_AmpStats *stats)
+{
+    *stats = g_sh->stats;
+}
+
+void NN_AmpFeederRun(void)
+{
+    NN_Buf *batch[NN_AMP_SLOTS];
+    u32 entry;
+
+    nn_amp_map();
+
+    if (NN_Init(NULL) < 0) {
+        /* CPU0 times out waiting for ready */
+        return;
+    }
+
+    __atomic_store_n(&g_sh->ready, 1, __ATOMIC_RELEASE);
+    nn_amp_kick();
+
+    for (;;) {
+        u16 n = 0;
+        int ret;
+
+        /* Everything CPU0 has queued goes out as one descriptor chain */
+        while (n < NN_AMP_SLOTS && NN_RingPop(&g_sh->req, &entry) == 0) {
+            batch[n++] = &g_slots[entry % NN_AMP_SLOTS];
+        }
+
+        if (n > 0) {
+            ret = NN_RunBatchBuf(batch, n, g_sh->num_inputs, g_sh->num_outputs);
+
+            /* At most NN_AMP_SLOTS are in flight, so the push cannot fail */
+            for (u16 f = 0; f < n; f++) {
+                NN_RingPush(&g_sh->done, batch[f]->id | (ret < 0 ? NN_AMP_FAILED : 0));
+            }
+            g_sh->stats.frames += n;
+            g_sh->stats.chains++;
+            if (ret < 0) {
+                g_sh->stats.failures += n;
+            }
+            nn_amp_kick();
+            continue;
+        }
+
+        if (__atomic_load_n(&g_sh->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        /* An SEV after the empty check leaves the event set, so this
+         * cannot miss a submission */
+        wfe();
+    }
+
+    __atomic_store_n(&g_sh->ready, 0, __ATOMIC_RELEASE);
+    nn_amp_kick();
+}
@@ -0,0 +1,124 @@
+/**
+ * @file nn_amp.h
+ * @brief Dual-core split: CPU0 prepares frames, CPU1 feeds the accelerator
+ *
+ * CPU1 runs a feeder that owns the accelerator and axi_dma_0 and does
+ * nothing else: it takes every frame CPU0 has queued, runs them as one
+ * descriptor chain (NN_RunBatchBuf()) and hands the slots back. CPU0 is
+ * free for preprocessing and post-processing in the meantime.
+ *
+ * Frames live in NN_AMP_SLOTS slots in DDR outside both applications'
+ * linker scripts. Slot numbers travel through two NN_Ring (request and
+ * done) in on-chip memory, mapped non-cacheable on both cores; the frame
+ * data itself stays cacheable and is flushed/invalidated by range.
+ */
+
+#ifndef NN_AMP_H
+#define NN_AMP_H
+
+#include "nn_buf.h"
+#include "nn_ring.h"
+
+/*==============================================================================
+ * Configuration
+ *============================================================================*/
+#define NN_AMP_SHARED_ADDR  0xFFFF0000  /* OCM high: rings and control */
+#define NN_AMP_FRAMES_ADDR  0x1F000000  /* DDR: slot data, reserved on both cores */
+#define NN_AMP_CPU1_ENTRY   0x10000000  /* CPU1 application start address */
+#define NN_AMP_CPU1_WAKE    0xFFFFFFF0  /* Boot ROM polls this for CPU1's PC */
+
+#define NN_AMP_SLOTS        32          /* Frames in flight (<= NN_MAX_BATCH) */
+#define NN_AMP_FAILED       (1u << 31)  /* Done entry: inference failed */
+#define NN_AMP_START_US     100000      /* Wait for CPU1 to come up */
+
+/*==============================================================================
+ * Data Types
+ *============================================================================*/
+
+/** Feeder counters */
+typedef struct {
+    u32 frames;                 /* Frames run */
+    u32 chains;                 /* Descriptor chains (one per wake-up) */
+    u32 failures;               /* Frames returned with NN_AMP_FAILED */
+} NN_AmpStats;
+
+/** Control block at NN_AMP_SHARED_ADDR */
+typedef struct {
+    NN_Ring req;                /* CPU0 -> CPU1: slots with packed inputs */
+    NN_Ring done;               /* CPU1 -> CPU0: slots with results */
+
+    u16 num_inputs;             /* Set by CPU0 before CPU1 starts */
+    u16 num_outputs;
+    u32 stop;                   /* CPU0: drain and exit */
+    u32 ready;                  /* CPU1: accelerator initialized */
+
+    NN_AmpStats stats;          /* Written by CPU1 only */
+} NN_AmpShared;
+
+/*==============================================================================
+ * Function Prototypes
+ *============================================================================*/
+
+/**
+ * @brief Map the shared block, reset the rings and start CPU1 (CPU0)
+ *
+ * CPU1 must have been loaded at NN_AMP_CPU1_ENTRY with an application
+ * that calls NN_AmpFeederRun(). CPU0 must not use the accelerator driver
+ * while the feeder runs.
+ *
+ * @param num_inputs Number of inputs per frame (<= NN_MAX_INPUTS)
+ * @param num_outputs Number of outputs per frame (<= NN_MAX_OUTPUTS)
+ * @return 0 on success, -1 if CPU1 did not report ready
+ */
+int NN_AmpInit(u16 num_inputs, u16 num_outputs);
+
+/**
+ * @brief Get a free slot to pack a frame into (CPU0)
+ * @return Slot buffer, NULL if all slots are in flight
+ */
+NN_Buf *NN_AmpAlloc(void);
+
+/**
+ * @brief Return a collected slot to the free list (CPU0)
+ * @param buf Slot from NN_AmpCollect()
+ */
+void NN_AmpFree(NN_Buf *buf);
+
+/**
+ * @brief Write back the packed inputs and queue the slot for CPU1 (CPU0)
+ * @param buf Slot from NN_AmpAlloc() with the inputs packed
+ * @return 0 on success, -1 on failure
+ */
+int NN_AmpSubmit(NN_Buf *buf);
+
+/**
+ * @brief Take one finished slot, if any (CPU0)
+ *
+ * The slot's result lines are invalidated, so NN_BufUnpack() sees what the
+ * DMA wrote.
+ *
+ * @param failed Set to 1 if the inference failed, else 0
+ * @return Finished slot, NULL if none is ready
+ */
+NN_Buf *NN_AmpCollect(int *failed);
+
+/**
+ * @brief Tell the feeder to finish the queued frames and exit (CPU0)
+ */
+void NN_AmpStop(void);
+
+/**
+ * @brief Get the feeder counters (CPU0)
+ * @param stats Pointer to stats structure
+ */
+void NN_AmpGetStats(NN_AmpStats *stats);
+
+/**
+ * @brief Feeder loop (CPU1)
+ *
+ * Initializes the accelerator, reports ready and runs queued frames until
+ * NN_AmpStop(). Sleeps in WFE while the request ring is empty.
+ */
+void NN_AmpFeederRun(void);
+
+#endif /* NN_AMP_H */
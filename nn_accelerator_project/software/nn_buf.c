@@ -0,0 +1,114 @@
+/**
+ * @file nn_buf.c
+ * @brief DMA-safe buffer pool and ranged cache maintenance
+ */
+
+#include "nn_buf.h"
+#include "xil_cache.h"
+#include "xil_mmu.h"
+#include "xpseudo_asm.h"
+
+/*==============================================================================
+ * Module Variables
+ *============================================================================*/
+
+/* Whole pool in one 1 MB MMU section so NN_BUF_NONCACHED needs a single
+ * translation table update. Each frame is a whole number of cache lines. */
+static struct {
+    u32 in[NN_BUF_POOL_SIZE][NN_MAX_INPUTS];
+    u32 out[NN_BUF_POOL_SIZE][NN_MAX_OUTPUTS];
+} g_pool __attribute__((aligned(NN_BUF_POOL_ALIGN)));
+
+static NN_Buf     g_bufs[NN_BUF_POOL_SIZE];
+static u16        g_free[NN_BUF_POOL_SIZE];
+static u16        g_free_count;
+static NN_BufMode g_mode = NN_BUF_CACHED;
+static u8         g_pool_ready;
+
+/*==============================================================================
+ * Function Implementations
+ *============================================================================*/
+
+int NN_BufPoolInit(NN_BufMode mode)
+{
+    if (sizeof(g_pool) > NN_BUF_POOL_ALIGN) {
+        return -1;
+    }
+
+    /* Make sure no dirty line is written back over DMA data later */
+    if (g_mode == NN_BUF_CACHED) {
+        Xil_DCacheFlushRange((INTPTR)&g_pool, sizeof(g_pool));
+    }
+
+    if (mode == NN_BUF_NONCACHED) {
+        Xil_SetTlbAttributes((UINTPTR)&g_pool, NORM_NONCACHE);
+    } else if (g_mode == NN_BUF_NONCACHED) {
+        Xil_SetTlbAttributes((UINTPTR)&g_pool, NORM_WB_CACHE);
+    }
+    g_mode = mode;
+
+    for (u16 i = 0; i < NN_BUF_POOL_SIZE; i++) {
+        g_bufs[i].in  = g_pool.in[i];
+        g_bufs[i].out = g_pool.out[i];
+        g_bufs[i].id  = i;
+        g_free[i] = NN_BUF_POOL_SIZE - 1 - i;
+    }
+    g_free_count = NN_BUF_POOL_SIZE;
+    g_pool_ready = 1;
+
+    return 0;
+}
+
+NN_BufMode NN_BufPoolMode(void)
+{
+    return g_mode;
+}
+
+NN_Buf *NN_BufAlloc(void)
+{
+    if (!g_pool_ready) {
+        NN_BufPoolInit(g_mode);
+    }
+    if (g_free_count == 0) {
+        return NULL;
+    }
+    return &g_bufs[g_free[--g_free_count]];
+}
+
+void NN_BufFree(NN_Buf *buf)
+{
+    if (buf != NULL && g_free_count < NN_BUF_POOL_SIZE) {
+        g_free[g_free_count++] = buf->id;
+    }
+}
+
+void NN_BufPack(NN_Buf *buf, const s16 *inputs, u16 num_inputs)
+{
+    for (u16 i = 0; i < num_inputs; i++) {
+        buf->in[i] = (u32)(s32)inputs[i];
+    }
+}
+
+void NN_BufUnpack(const NN_Buf *buf, s16 *outputs, u16 num_outputs)
+{
+    for (u16 i = 0; i < num_outputs; i++) {
+        outputs[i] = (s16)(buf->out[i] & 0xFFFF);
+    }
+}
+
+void NN_CacheFlushRange(const void *addr, u32 len)
+{
+    if (g_mode == NN_BUF_CACHED) {
+        Xil_DCacheFlushRange((INTPTR)addr, len);
+    } else {
+        /* Drain the write buffer before the DMA is kicked */
+        dsb();
+    }
+}
+
+void NN_CacheInvalidateRange(const void *addr, u32 len)
+{
+    if (g_mode == NN_BUF_CACHED) {
+        Xil_DCacheInvalidateRange((INTPTR)addr, len);
+    }
+}
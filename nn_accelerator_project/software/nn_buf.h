@@ -0,0 +1,157 @@
+/**
+ * @file nn_buf.h
+ * @brief DMA-safe buffer pool and ranged cache maintenance
+ *
+ * Every pool buffer starts on a cache line and occupies whole lines, so
+ * flushing or invalidating it never touches unrelated data. Applications
+ * can pack inputs straight into a pool buffer and hand it to the driver
+ * without an extra copy.
+ */
+
+#ifndef NN_BUF_H
+#define NN_BUF_H
+
+#include "nn_driver.h"
+
+/*==============================================================================
+ * Configuration
+ *============================================================================*/
+#ifndef NN_BUF_POOL_SIZE
+#define NN_BUF_POOL_SIZE    NN_MAX_BATCH    /* Buffers in the pool */
+#endif
+
+#define NN_BUF_POOL_ALIGN   0x100000        /* One MMU section (1 MB) */
+
+/*==============================================================================
+ * Data Types
+ *============================================================================*/
+
+/**
+ * Cache handling for the pool.
+ *   NN_BUF_CACHED:    normal cacheable memory, ranged flush/invalidate
+ *   NN_BUF_NONCACHED: pool section remapped non-cacheable, no maintenance
+ *   NN_BUF_COHERENT:  DMA is cache-coherent (ACP), no maintenance
+ */
+typedef enum {
+    NN_BUF_CACHED = 0,
+    NN_BUF_NONCACHED,
+    NN_BUF_COHERENT
+} NN_BufMode;
+
+typedef struct {
+    u32 *in;        /* NN_MAX_INPUTS AXIS beats */
+    u32 *out;       /* NN_MAX_OUTPUTS AXIS beats */
+    u16  id;        /* Pool slot */
+} NN_Buf;
+
+/*==============================================================================
+ * Function Prototypes
+ *============================================================================*/
+
+/**
+ * @brief Initialize (or re-initialize) the buffer pool
+ *
+ * All buffers return to the free list. Switching away from
+ * NN_BUF_NONCACHED restores the default cacheable mapping.
+ *
+ * @param mode Cache handling for the pool
+ * @return 0 on success, -1 on failure
+ */
+int NN_BufPoolInit(NN_BufMode mode);
+
+/**
+ * @brief Get the current pool cache mode
+ * @return Pool cache mode
+ */
+NN_BufMode NN_BufPoolMode(void);
+
+/**
+ * @brief Take a buffer from the pool
+ * @return Buffer, or NULL if the pool is empty
+ */
+NN_Buf *NN_BufAlloc(void);
+
+/**
+ * @brief Return a buffer to the pool
+ * @param buf Buffer from NN_BufAlloc()
+ */
+void NN_BufFree(NN_Buf *buf);
+
+/**
+ * @brief Pack S.4.11 inputs into AXIS beats (one sign-extended value each)
+ * @param buf Destination buffer
+ * @param inputs Input data array (fixed-point)
+ * @param num_inputs Number of inputs (<= NN_MAX_INPUTS)
+ */
+void NN_BufPack(NN_Buf *buf, const s16 *inputs, u16 num_inputs);
+
+/**
+ * @brief Unpack result beats into S.4.11 outputs
+ * @param buf Source buffer
+ * @param outputs Output data array (fixed-point)
+ * @param num_outputs Number of outputs (<= NN_MAX_OUTPUTS)
+ */
+void NN_BufUnpack(const NN_Buf *buf, s16 *outputs, u16 num_outputs);
+
+/**
+ * @brief Write back a range before the DMA reads it
+ *
+ * The range is widened to whole cache lines. No-op unless the pool is
+ * NN_BUF_CACHED.
+ *
+ * @param addr Start address
+ * @param len Length in bytes
+ */
+void NN_CacheFlushRange(const void *addr, u32 len);
+
+/**
+ * @brief Discard cached copies of a range the DMA writes
+ *
+ * The range is widened to whole cache lines. No-op unless the pool is
+ * NN_BUF_CACHED.
+ *
+ * @param addr Start address
+ * @param len Length in bytes
+ */
+void NN_CacheInvalidateRange(const void *addr, u32 len);
+
+/**
+ * @brief Run one inference on a pool buffer (zero-copy)
+ *
+ * Same as NN_RunInference() but reads buf->in and writes buf->out
+ * directly; only the bytes the DMA touches are flushed/invalidated.
+ *
+ * @param buf Buffer holding num_inputs packed input beats
+ * @param num_inputs Number of inputs (<= NN_MAX_INPUTS)
+ * @param num_outputs Number of outputs (<= NN_MAX_OUTPUTS)
+ * @return 0 on success, -1 on failure
+ */
+int NN_RunInferenceBuf(NN_Buf *buf, u16 num_inputs, u16 num_outputs);
+
+/**
+ * @brief Run a batch on pool buffers (zero-copy)
+ * @param bufs count buffers holding packed inputs
+ * @param count Number of buffers (1 to NN_MAX_BATCH)
+ * @param num_inputs Number of inputs per frame (<= NN_MAX_INPUTS)
+ * @param num_outputs Number of outputs per frame (<= NN_MAX_OUTPUTS)
+ * @return 0 on success, -1 on failure
+ */
+int NN_RunBatchBuf(NN_Buf **bufs, u16 count, u16 num_inputs, u16 num_outputs);
+
+/**
+ * @brief Classify one pool buffer without reading the outputs back
+ *
+ * Sets CLASS_ONLY, streams buf->in over MM2S and polls STATUS until DONE;
+ * that same read carries the hardware argmax. There is no S2MM transfer
+ * and no invalidate of buf->out. Watchdog rules are those of
+ * NN_RunInferenceBuf(). Without continuous mode a core left in S_DONE is
+ * soft-reset first, since it would ignore START and the poll would see
+ * the previous frame's DONE and class.
+ *
+ * @param buf Buffer holding num_inputs packed input beats
+ * @param num_inputs Number of inputs (<= NN_MAX_INPUTS)
+ * @return Predicted class (0 to num_outputs-1), -1 on failure
+ */
+int NN_ClassifyBuf(NN_Buf *buf, u16 num_inputs);
+
+#endif /* NN_BUF_H */
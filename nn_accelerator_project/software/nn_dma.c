@@ -0,0 +1,276 @@
+/**
+ * @file nn_dma.c
+ * @brief AXI DMA transport implementation (simple and scatter-gather)
+ */
+
+#include "nn_dma.h"
+
+/*==============================================================================
+ * Module Variables
+ *============================================================================*/
+static XAxiDma g_dma;
+static int     g_has_sg;
+
+/* Descriptor storage, one ring per channel, one descriptor per frame */
+static u8 g_tx_bd_space[NN_MAX_BATCH * XAXIDMA_BD_MINIMUM_ALIGNMENT]
+    __attribute__((aligned(XAXIDMA_BD_MINIMUM_ALIGNMENT)));
+static u8 g_rx_bd_space[NN_MAX_BATCH * XAXIDMA_BD_MINIMUM_ALIGNMENT]
+    __attribute__((aligned(XAXIDMA_BD_MINIMUM_ALIGNMENT)));
+
+/*==============================================================================
+ * Local Helpers
+ *============================================================================*/
+
+static int nn_ring_setup(XAxiDma_BdRing *ring, u8 *space, u32 size)
+{
+    XAxiDma_Bd template;
+    u32 bd_count = XAxiDma_BdRingCntCalc(XAXIDMA_BD_MINIMUM_ALIGNMENT, size);
+
+    XAxiDma_BdRingIntDisable(ring, XAXIDMA_IRQ_ALL_MASK);
+
+    if (XAxiDma_BdRingCreate(ring, (UINTPTR)space, (UINTPTR)space,
+                             XAXIDMA_BD_MINIMUM_ALIGNMENT,
+                             bd_count) != XST_SUCCESS) {
+        return -1;
+    }
+
+    XAxiDma_BdClear(&template);
+    if (XAxiDma_BdRingClone(ring, &template) != XST_SUCCESS) {
+        return -1;
+    }
+
+    return (XAxiDma_BdRingStart(ring) == XST_SUCCESS) ? 0 : -1;
+}
+
+static int nn_sg_setup(void)
+{
+    if (nn_ring_setup(XAxiDma_GetRxRing(&g_dma), g_rx_bd_space,
+                      sizeof(g_rx_bd_space)) < 0) {
+        return -1;
+    }
+    return nn_ring_setup(XAxiDma_GetTxRing(&g_dma), g_tx_bd_space,
+                         sizeof(g_tx_bd_space));
+}
+
+static int nn_ring_fill(XAxiDma_BdRing *ring, const UINTPTR *addr, u32 len,
+                        u32 ctrl, u16 count, XAxiDma_Bd **head)
+{
+    XAxiDma_Bd *bd;
+
+    if (XAxiDma_BdRingAlloc(ring, count, head) != XST_SUCCESS) {
+        return -1;
+    }
+
+    bd = *head;
+    for (u16 i = 0; i < count; i++) {
+        if (XAxiDma_BdSetBufAddr(bd, addr[i]) != XST_SUCCESS ||
+            XAxiDma_BdSetLength(bd, len, ring->MaxTransferLen) != XST_SUCCESS) {
+            XAxiDma_BdRingUnAlloc(ring, count, *head);
+            return -1;
+        }
+        XAxiDma_BdSetCtrl(bd, ctrl);
+        XAxiDma_BdSetId(bd, i);
+        bd = (XAxiDma_Bd *)XAxiDma_BdRingNext(ring, bd);
+    }
+
+    return 0;
+}
+
+static int nn_sg_submit(const UINTPTR *tx_addr, u32 tx_len,
+                        const UINTPTR *rx_addr, u32 rx_len, u16 count)
+{
+    XAxiDma_BdRing *tx_ring = XAxiDma_GetTxRing(&g_dma);
+    XAxiDma_BdRing *rx_ring = XAxiDma_GetRxRing(&g_dma);
+    XAxiDma_Bd *tx_head, *rx_head;
+
+    /* One result block per frame; the core ends each with TLAST */
+    if (nn_ring_fill(rx_ring, rx_addr, rx_len, 0, count, &rx_head) < 0) {
+        return -1;
+    }
+
+    /* One input frame per descriptor, TLAST on the last beat */
+    if (nn_ring_fill(tx_ring, tx_addr, tx_len,
+                     XAXIDMA_BD_CTRL_TXSOF_MASK | XAXIDMA_BD_CTRL_TXEOF_MASK,
+                     count, &tx_head) < 0) {
+        XAxiDma_BdRingUnAlloc(rx_ring, count, rx_head);
+        return -1;
+    }
+
+    /* A single tail pointer write per channel starts the whole chain */
+    if (XAxiDma_BdRingToHw(rx_ring, count, rx_head) != XST_SUCCESS) {
+        return -1;
+    }
+    if (XAxiDma_BdRingToHw(tx_ring, count, tx_head) != XST_SUCCESS) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Reclaim whatever the hardware has finished; -1 if any BD has an error */
+static int nn_sg_reclaim(XAxiDma_BdRing *ring)
+{
+    XAxiDma_Bd *bd, *first;
+    int n;
+
+    n = XAxiDma_BdRingFromHw(ring, XAXIDMA_ALL_BDS, &first);
+    if (n == 0) {
+        return 0;
+    }
+
+    bd = first;
+    for (int i = 0; i < n; i++) {
+        if (XAxiDma_BdGetSts(bd) & XAXIDMA_BD_STS_ALL_ERR_MASK) {
+            XAxiDma_BdRingFree(ring, n, first);
+            return -1;
+        }
+        bd = (XAxiDma_Bd *)XAxiDma_BdRingNext(ring, bd);
+    }
+
+    XAxiDma_BdRingFree(ring, n, first);
+    return n;
+}
+
+static int nn_sg_wait(XAxiDma_BdRing *ring, u16 count, XTime deadline)
+{
+    u16 reclaimed = 0;
+    int n;
+
+    while (reclaimed < count) {
+        n = nn_sg_reclaim(ring);
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0 && NN_Expired(deadline)) {
+            return -1;
+        }
+        reclaimed += n;
+    }
+
+    return 0;
+}
+
+/*==============================================================================
+ * Function Implementations
+ *============================================================================*/
+
+int NN_DmaInit(u16 device_id)
+{
+    XAxiDma_Config *cfg = XAxiDma_LookupConfig(device_id);
+
+    if (cfg == NULL) {
+        return -1;
+    }
+    if (XAxiDma_CfgInitialize(&g_dma, cfg) != XST_SUCCESS) {
+        return -1;
+    }
+
+    g_has_sg = XAxiDma_HasSg(&g_dma) ? 1 : 0;
+
+    if (g_has_sg) {
+        return nn_sg_setup();
+    }
+
+    /* Simple mode; completions are polled */
+    XAxiDma_IntrDisable(&g_dma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DEVICE_TO_DMA);
+    XAxiDma_IntrDisable(&g_dma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DMA_TO_DEVICE);
+
+    return 0;
+}
+
+int NN_DmaHasSg(void)
+{
+    return g_has_sg;
+}
+
+int NN_DmaSubmit(const UINTPTR *tx_addr, u32 tx_len,
+                 const UINTPTR *rx_addr, u32 rx_len, u16 count)
+{
+    if (count == 0 || count > NN_MAX_BATCH) {
+        return -1;
+    }
+
+    if (g_has_sg) {
+        return nn_sg_submit(tx_addr, tx_len, rx_addr, rx_len, count);
+    }
+
+    if (count != 1) {
+        return -1;
+    }
+
+    /* Arm S2MM first so the result stream is never back-pressured */
+    if (XAxiDma_SimpleTransfer(&g_dma, rx_addr[0], rx_len,
+                               XAXIDMA_DEVICE_TO_DMA) != XST_SUCCESS) {
+        return -1;
+    }
+    if (XAxiDma_SimpleTransfer(&g_dma, tx_addr[0], tx_len,
+                               XAXIDMA_DMA_TO_DEVICE) != XST_SUCCESS) {
+        NN_DmaAbort();
+        return -1;
+    }
+
+    return 0;
+}
+
+int NN_DmaSend(UINTPTR addr, u32 len)
+{
+    if (g_has_sg) {
+        XAxiDma_BdRing *tx_ring = XAxiDma_GetTxRing(&g_dma);
+        XAxiDma_Bd *tx_head;
+
+        if (nn_ring_fill(tx_ring, &addr, len,
+                         XAXIDMA_BD_CTRL_TXSOF_MASK | XAXIDMA_BD_CTRL_TXEOF_MASK,
+                         1, &tx_head) < 0) {
+            return -1;
+        }
+        return (XAxiDma_BdRingToHw(tx_ring, 1, tx_head) == XST_SUCCESS) ? 0 : -1;
+    }
+
+    if (XAxiDma_SimpleTransfer(&g_dma, addr, len,
+                               XAXIDMA_DMA_TO_DEVICE) != XST_SUCCESS) {
+        return -1;
+    }
+    return 0;
+}
+
+int NN_DmaWait(int direction, u16 count, XTime deadline)
+{
+    if (g_has_sg) {
+        XAxiDma_BdRing *ring = (direction == NN_DMA_TX) ?
+                               XAxiDma_GetTxRing(&g_dma) :
+                               XAxiDma_GetRxRing(&g_dma);
+        return nn_sg_wait(ring, count, deadline);
+    }
+
+    while (XAxiDma_Busy(&g_dma, direction)) {
+        if (NN_Expired(deadline)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int NN_DmaPoll(int direction)
+{
+    if (g_has_sg) {
+        XAxiDma_BdRing *ring = (direction == NN_DMA_TX) ?
+                               XAxiDma_GetTxRing(&g_dma) :
+                               XAxiDma_GetRxRing(&g_dma);
+        return nn_sg_reclaim(ring);
+    }
+
+    return XAxiDma_Busy(&g_dma, direction) ? 0 : 1;
+}
+
+void NN_DmaAbort(void)
+{
+    XAxiDma_Reset(&g_dma);
+    while (!XAxiDma_ResetIsDone(&g_dma)) {
+        /* Reset completes within a few AXI clocks */
+    }
+
+    /* Reset drops every descriptor; rebuild the rings */
+    if (g_has_sg) {
+        nn_sg_setup();
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * @file nn_dma.h
+ * @brief AXI DMA transport for the NN accelerator streams
+ *
+ * Wraps axi_dma_0 in either simple (register) mode or scatter-gather mode,
+ * depending on how the IP was built. In SG mode a whole batch is described
+ * by one descriptor chain per channel and started with a single tail
+ * pointer write per channel.
+ */
+
+#ifndef NN_DMA_H
+#define NN_DMA_H
+
+#include "nn_driver.h"
+#include "xaxidma.h"
+
+/*==============================================================================
+ * Channel Directions
+ *============================================================================*/
+#define NN_DMA_TX           XAXIDMA_DMA_TO_DEVICE   /* MM2S: inputs */
+#define NN_DMA_RX           XAXIDMA_DEVICE_TO_DMA   /* S2MM: results */
+
+/*==============================================================================
+ * Function Prototypes
+ *============================================================================*/
+
+/**
+ * @brief Check whether the DMA was built with scatter-gather
+ * @return 1 if SG, 0 if simple mode
+ */
+int NN_DmaHasSg(void);
+
+/**
+ * @brief Queue count frames on both channels
+ *
+ * Frame k is read from tx_addr[k] and its results are written to
+ * rx_addr[k]. The S2MM side is armed before MM2S. Simple mode accepts
+ * count == 1 only.
+ *
+ * @param tx_addr Input frame addresses (cache-line aligned)
+ * @param tx_len  Bytes per input frame
+ * @param rx_addr Result block addresses (cache-line aligned)
+ * @param rx_len  Bytes per result block
+ * @param count   Number of frames (1 to NN_MAX_BATCH)
+ * @return 0 on success, -1 on failure
+ */
+int NN_DmaSubmit(const UINTPTR *tx_addr, u32 tx_len,
+                 const UINTPTR *rx_addr, u32 rx_len, u16 count);
+
+/**
+ * @brief Queue a single MM2S transfer with no result stream
+ *
+ * Used for model uploads. The block ends with TLAST.
+ *
+ * @param addr Source address (cache-line aligned)
+ * @param len  Bytes to send
+ * @return 0 on success, -1 on failure
+ */
+int NN_DmaSend(UINTPTR addr, u32 len);
+
+/**
+ * @brief Wait until count frames have completed on one channel
+ * @param direction NN_DMA_TX or NN_DMA_RX
+ * @param count Number of frames submitted on that channel
+ * @param deadline Absolute global timer value to give up at
+ * @return 0 on success, -1 on timeout or descriptor error
+ */
+int NN_DmaWait(int direction, u16 count, XTime deadline);
+
+/**
+ * @brief Reclaim finished frames on one channel without waiting
+ *
+ * In SG mode returns the number of descriptors completed since the last
+ * call. In simple mode returns 1 once the outstanding transfer is done, so
+ * call it only while one is outstanding.
+ *
+ * @param direction NN_DMA_TX or NN_DMA_RX
+ * @return Frames completed (0 if none), -1 on descriptor error
+ */
+int NN_DmaPoll(int direction);
+
+/**
+ * @brief Reset the DMA and discard all outstanding descriptors
+ */
+void NN_DmaAbort(void);
+
+#endif /* NN_DMA_H */
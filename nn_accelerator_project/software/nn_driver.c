@@ -4,8 +4,15 @@
  */
 
 #include "nn_driver.h"
+#include "nn_buf.h"
+#include "nn_dma.h"
+#include "nn_stats.h"
 #include "sleep.h"
+#include "xil_cache.h"
 #include <string.h>
+#if NN_ACTIVATION == NN_ACT_SIGMOID_LUT
+#include <math.h>
+#endif
 
 /*==============================================================================
  * Module Variables
@@ -16,9 +23,263 @@ static NN_Config g_config = {
     .num_hidden1 = NN_DEFAULT_NUM_H1,
     .num_hidden2 = NN_DEFAULT_NUM_H2,
     .num_outputs = NN_DEFAULT_NUM_OUT,
+    .dma_device_id = NN_DMA_DEVICE_ID,
     .initialized = 0
 };
 
+static NN_Timing    g_timing;
+static NN_MmioStats g_mmio;
+
+/* Shadow copies of the writable registers. CTRL never holds START;
+ * the topology shadows are the num_* fields of g_config. */
+static u32 g_ctrl;
+static u16 g_num_w;
+static u16 g_irq_count;
+static u32 g_irq_timeout;
+
+/* Watchdog: expected accelerator ticks per frame, seeded from the cycle
+ * model and tracked from completed frames */
+static XTime      g_wd_model;
+static XTime      g_wd_expect;
+static NN_WdStats g_wd;
+
+static NN_CompletionHandler g_complete_cb;
+static void                *g_complete_ref;
+static u8  g_topo_valid;
+
+/* Model upload staging: weights then biases, one beat each */
+static u32 g_model_buf[NN_MAX_WEIGHTS + NN_MAX_BIASES]
+    __attribute__((aligned(NN_CACHE_LINE)));
+
+/* Activation tables, as in the .mem files network.py writes */
+#if NN_ACTIVATION == NN_ACT_SIGMOID_INTERP
+#define NN_SIG_SEGS     64
+#define NN_SIG_FRAC_W   9               /* NN_FRAC_BITS + 4 - log2(NN_SIG_SEGS) */
+static const s16 g_sig_interp[NN_SIG_SEGS + 1] = {
+       1,    1,    1,    1,    2,    2,    3,    4,    5,    6,    8,   11,
+      14,   18,   23,   29,   37,   47,   60,   76,   97,  123,  155,  195,
+     244,  303,  374,  456,  551,  657,  773,  897, 1024, 1151, 1275, 1391,
+    1497, 1592, 1674, 1745, 1804, 1853, 1893, 1925, 1951, 1972, 1988, 2001,
+    2011, 2019, 2025, 2030, 2034, 2037, 2040, 2042, 2043, 2044, 2045, 2046,
+    2046, 2047, 2047, 2047, 2047
+};
+#elif NN_ACTIVATION == NN_ACT_SIGMOID_LUT
+#define NN_SIG_LUT_SIZE 1024
+static s16 g_sig_lut[NN_SIG_LUT_SIZE];
+static u8  g_sig_lut_ready;
+#endif
+
+/*==============================================================================
+ * Local Helpers
+ *============================================================================*/
+
+static inline u32 nn_read(NN_MmioOp op, u32 offset)
+{
+    g_mmio.reads[op]++;
+    return NN_READ(offset);
+}
+
+static inline void nn_write(NN_MmioOp op, u32 offset, u32 val)
+{
+    g_mmio.writes[op]++;
+    NN_WRITE(offset, val);
+}
+
+static void nn_write_ctrl(NN_MmioOp op, u32 ctrl)
+{
+    if (ctrl == g_ctrl) {
+        g_mmio.skipped[op]++;
+        return;
+    }
+    g_ctrl = ctrl;
+    nn_write(op, NN_REG_CTRL, ctrl);
+}
+
+static void nn_write_topo(u32 offset, u16 *shadow, u16 val)
+{
+    if (g_topo_valid && *shadow == val) {
+        g_mmio.skipped[NN_OP_CONFIGURE]++;
+        return;
+    }
+    *shadow = val;
+    nn_write(NN_OP_CONFIGURE, offset, val);
+}
+
+static int nn_wait_state(u8 state, XTime deadline)
+{
+    NN_Status status;
+
+    for (;;) {
+        NN_GetStatus(&status);
+        if (status.done || status.state >= state) {
+            return 0;
+        }
+        if (NN_Expired(deadline)) {
+            return -1;
+        }
+    }
+}
+
+static int nn_wait_idle(XTime deadline)
+{
+    while (nn_read(NN_OP_MODEL, NN_REG_STATUS) & NN_STAT_BUSY) {
+        if (NN_Expired(deadline)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Without continuous mode a finished core holds S_DONE, with DONE and the
+ * last class still set, and ignores START. Soft-reset it so the next
+ * START is taken (mode bits survive, see NN_Reset()). */
+static void nn_rearm(void)
+{
+    u32 status;
+    
+    if (g_ctrl & NN_CTRL_CONTINUOUS) {
+        return;
+    }
+    status = nn_read(NN_OP_STATUS, NN_REG_STATUS);
+    if (((status & NN_STAT_STATE_MASK) >> NN_STAT_STATE_SHIFT) == NN_STATE_DONE) {
+        NN_Reset();
+    }
+}
+
+static u32 nn_fnv1a(u32 hash, const void *data, u32 len)
+{
+    const u8 *p = (const u8 *)data;
+
+    for (u32 i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int nn_check_args(u16 num_inputs, u16 num_outputs)
+{
+    if (!g_config.initialized) {
+        if (NN_Init(NULL) < 0) {
+            return -1;
+        }
+    }
+
+    if (num_inputs > NN_MAX_INPUTS || num_outputs > NN_MAX_OUTPUTS) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Cycles per inference for the current topology (nn_accelerator_core FSM):
+ * per neuron group one S_LOAD_B and one S_COMPUTE per NN_IN_PARALLEL
+ * inputs (at least NN_PARALLEL, the store of the previous group), per
+ * layer the MAC/sigmoid drain and the last group's NN_PARALLEL store
+ * cycles. Layer 0 is taken at full size, the bound for zero skipping. */
+#define NN_ACT_DRAIN_CYCLES (NN_MAC_PIPE_STAGES + 4)
+
+static XTime nn_wd_model(void)
+{
+    const u16 size[4] = { g_config.num_inputs, g_config.num_hidden1,
+                          g_config.num_hidden2, g_config.num_outputs };
+    u64 cycles = 2 + size[0] + 2 * (u64)size[3];
+    
+    for (int l = 0; l < NN_WEIGHT_LAYERS; l++) {
+        u32 groups = (size[l + 1] + NN_PARALLEL - 1) / NN_PARALLEL;
+        u32 words = (size[l] + NN_IN_PARALLEL - 1) / NN_IN_PARALLEL;
+        u32 issue = (words > NN_PARALLEL) ? words : NN_PARALLEL;
+        cycles += (u64)groups * (1 + issue) + NN_ACT_DRAIN_CYCLES + NN_PARALLEL + 1;
+    }
+    
+    return (XTime)((cycles * COUNTS_PER_SECOND) / NN_CLK_HZ);
+}
+
+static XTime nn_wd_limit(int attempt)
+{
+    u64 limit = ((u64)g_wd_expect * NN_WD_MULT) << attempt;
+    u64 cap = ((u64)NN_INFERENCE_TIMEOUT_US * COUNTS_PER_SECOND) / 1000000ULL;
+    
+    limit += ((u64)NN_WD_SLACK_US * COUNTS_PER_SECOND) / 1000000ULL;
+    return (XTime)((limit < cap) ? limit : cap);
+}
+
+static inline XTime nn_wd_deadline(int attempt)
+{
+    XTime now;
+    XTime_GetTime(&now);
+    return now + nn_wd_limit(attempt);
+}
+
+/* Track the observed per-frame time (EWMA, 1/8), never below half the model */
+static void nn_wd_learn(XTime observed)
+{
+    s64 delta = (s64)observed - (s64)g_wd_expect;
+    
+    g_wd_expect = (XTime)((s64)g_wd_expect + delta / 8);
+    if (g_wd_expect < g_wd_model / 2) {
+        g_wd_expect = g_wd_model / 2;
+    }
+}
+
+static int nn_wd_hang(int attempt)
+{
+    g_wd.hangs++;
+    NN_Recover();
+    if (attempt >= NN_WD_RETRIES) {
+        g_wd.failures++;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Run n frames as one descriptor chain (n == 1 in simple mode). *done
+ * counts finished frames; the watchdog restarts at every completion, so a
+ * long chain only needs each frame to finish within the limit.
+ */
+static int nn_run_chain(const UINTPTR *tx_addr, u32 tx_len,
+                        const UINTPTR *rx_addr, u32 rx_len,
+                        u16 n, u16 *done, int attempt)
+{
+    XTime deadline;
+    u16 tx_done = 0;
+    int k;
+    
+    if (NN_DmaSubmit(tx_addr, tx_len, rx_addr, rx_len, n) < 0) {
+        return -1;
+    }
+    deadline = nn_wd_deadline(attempt);
+    
+    while (*done < n || tx_done < n) {
+        if (tx_done < n) {
+            k = NN_DmaPoll(NN_DMA_TX);
+            if (k < 0) {
+                return -1;
+            }
+            tx_done += k;
+        }
+        
+        if (*done < n) {
+            k = NN_DmaPoll(NN_DMA_RX);
+            if (k < 0) {
+                return -1;
+            }
+            if (k > 0) {
+                *done += k;
+                deadline = nn_wd_deadline(attempt);
+                continue;
+            }
+        }
+        
+        if (NN_Expired(deadline)) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
 /*==============================================================================
  * Function Implementations
  *============================================================================*/
@@ -30,14 +291,22 @@ int NN_Init(NN_Config *config)
         memcpy(&g_config, config, sizeof(NN_Config));
     }
     
+    /* Bring up the data path */
+    if (NN_DmaInit(g_config.dma_device_id) < 0) {
+        return -1;
+    }
+    
     /* Soft reset */
     NN_Reset();
+    memset(&g_wd, 0, sizeof(g_wd));
     
-    /* Configure network topology */
+    /* Configure network topology; every register is written once */
+    g_topo_valid = 0;
     NN_Configure(g_config.num_inputs, 
                  g_config.num_hidden1,
                  g_config.num_hidden2, 
                  g_config.num_outputs);
+    g_topo_valid = 1;
     
     /* Mark as initialized */
     g_config.initialized = 1;
@@ -47,55 +316,116 @@ int NN_Init(NN_Config *config)
 
 void NN_Reset(void)
 {
+    /* Mode bits survive the reset, enable does not */
+    u32 mode = g_ctrl & (NN_CTRL_CONTINUOUS | NN_CTRL_RAW_OUT);
+    
     /* Assert soft reset */
-    NN_WRITE(NN_REG_CTRL, NN_CTRL_SOFT_RESET);
+    nn_write(NN_OP_RESET, NN_REG_CTRL, NN_CTRL_SOFT_RESET | mode);
     usleep(10);
     
     /* De-assert soft reset */
-    NN_WRITE(NN_REG_CTRL, 0);
+    g_ctrl = mode;
+    nn_write(NN_OP_RESET, NN_REG_CTRL, mode);
     usleep(10);
 }
 
+void NN_Recover(void)
+{
+    u32 ctrl = g_ctrl;
+    
+    /* Drop every outstanding descriptor, then the core's state */
+    NN_DmaAbort();
+    NN_Reset();
+    
+    /* Back to the configuration the caller had */
+    g_topo_valid = 0;
+    NN_Configure(g_config.num_inputs, g_config.num_hidden1,
+                 g_config.num_hidden2, g_config.num_outputs);
+    g_topo_valid = 1;
+    nn_write_ctrl(NN_OP_RESET, ctrl);
+}
+
+void NN_GetWdStats(NN_WdStats *stats)
+{
+    *stats = g_wd;
+    stats->expected_us = NN_TICKS_TO_US(g_wd_expect);
+    stats->limit_us    = NN_TICKS_TO_US(nn_wd_limit(0));
+}
+
 void NN_Configure(u16 num_in, u16 num_h1, u16 num_h2, u16 num_out)
 {
-    NN_WRITE(NN_REG_NUM_IN,  num_in);
-    NN_WRITE(NN_REG_NUM_H1,  num_h1);
-    NN_WRITE(NN_REG_NUM_H2,  num_h2);
-    NN_WRITE(NN_REG_NUM_OUT, num_out);
+    /* Only registers that differ from the shadow are written */
+    nn_write_topo(NN_REG_NUM_IN,  &g_config.num_inputs,  num_in);
+    nn_write_topo(NN_REG_NUM_H1,  &g_config.num_hidden1, num_h1);
+    nn_write_topo(NN_REG_NUM_H2,  &g_config.num_hidden2, num_h2);
+    nn_write_topo(NN_REG_NUM_OUT, &g_config.num_outputs, num_out);
     
-    /* Update local config */
-    g_config.num_inputs  = num_in;
-    g_config.num_hidden1 = num_h1;
-    g_config.num_hidden2 = num_h2;
-    g_config.num_outputs = num_out;
+    /* New topology: start the watchdog from the cycle model again */
+    if (nn_wd_model() != g_wd_model) {
+        g_wd_model  = nn_wd_model();
+        g_wd_expect = g_wd_model;
+    }
 }
 
 int NN_IsBusy(void)
 {
-    u32 status = NN_READ(NN_REG_STATUS);
+    u32 status = nn_read(NN_OP_STATUS, NN_REG_STATUS);
     return (status & NN_STAT_BUSY) ? 1 : 0;
 }
 
 int NN_IsDone(void)
 {
-    u32 status = NN_READ(NN_REG_STATUS);
+    u32 status = nn_read(NN_OP_STATUS, NN_REG_STATUS);
     return (status & NN_STAT_DONE) ? 1 : 0;
 }
 
 void NN_GetStatus(NN_Status *status)
 {
-    u32 reg = NN_READ(NN_REG_STATUS);
+    u32 reg = nn_read(NN_OP_STATUS, NN_REG_STATUS);
     
     status->busy  = (reg & NN_STAT_BUSY) ? 1 : 0;
     status->done  = (reg & NN_STAT_DONE) ? 1 : 0;
     status->state = (reg & NN_STAT_STATE_MASK) >> NN_STAT_STATE_SHIFT;
+    status->predicted = (reg & NN_STAT_CLASS_MASK) >> NN_STAT_CLASS_SHIFT;
+    status->in_ready  = (reg & NN_STAT_IN_READY) ? 1 : 0;
+    status->margin    = (reg & NN_STAT_MARGIN_MASK) >> NN_STAT_MARGIN_SHIFT;
 }
 
 void NN_Start(void)
 {
-    u32 ctrl = NN_READ(NN_REG_CTRL);
-    ctrl |= NN_CTRL_ENABLE | NN_CTRL_START;
-    NN_WRITE(NN_REG_CTRL, ctrl);
+    /* START self-clears in hardware, so the shadow keeps only ENABLE */
+    g_ctrl |= NN_CTRL_ENABLE;
+    nn_write(NN_OP_START, NN_REG_CTRL, g_ctrl | NN_CTRL_START);
+}
+
+void NN_SetContinuous(int enable)
+{
+    if (enable) {
+        nn_write_ctrl(NN_OP_MODE, g_ctrl | NN_CTRL_CONTINUOUS);
+    } else {
+        nn_write_ctrl(NN_OP_MODE, g_ctrl & ~NN_CTRL_CONTINUOUS);
+    }
+}
+
+void NN_SetRawOutput(int enable)
+{
+    if (enable) {
+        nn_write_ctrl(NN_OP_MODE, g_ctrl | NN_CTRL_RAW_OUT);
+    } else {
+        nn_write_ctrl(NN_OP_MODE, g_ctrl & ~NN_CTRL_RAW_OUT);
+    }
+}
+
+void NN_GetScore(s16 *score, u16 *margin)
+{
+    u32 reg = nn_read(NN_OP_STATUS, NN_REG_SCORE);
+    
+    if (score != NULL) {
+        *score = (s16)(reg & NN_SCORE_VAL_MASK);
+    }
+    if (margin != NULL) {
+        *margin = (u16)((reg & NN_SCORE_MARGIN_MASK) >> NN_SCORE_MARGIN_SHIFT);
+    }
 }
 
 int NN_WaitDone(u32 timeout_us)
@@ -114,37 +444,727 @@ int NN_WaitDone(u32 timeout_us)
     return 0;
 }
 
+int NN_RunInferenceBuf(NN_Buf *buf, u16 num_inputs, u16 num_outputs)
+{
+    NN_Trace tr;
+    XTime deadline;
+    const u32 tx_len = num_inputs * NN_AXIS_BEAT_BYTES;
+    const u32 rx_len = num_outputs * NN_AXIS_BEAT_BYTES;
+    const UINTPTR tx_addr = (UINTPTR)buf->in;
+    const UINTPTR rx_addr = (UINTPTR)buf->out;
+    int attempt = 0;
+    
+    tr.t[NN_TS_SUBMIT] = NN_Now();
+    
+    if (nn_check_args(num_inputs, num_outputs) < 0) {
+        return -1;
+    }
+    
+    /* Only the bytes the DMA touches, not the whole cache */
+    NN_CacheFlushRange(buf->in, tx_len);
+    NN_CacheInvalidateRange(buf->out, rx_len);
+    nn_rearm();
+    
+retry:
+    deadline = nn_wd_deadline(attempt);
+    
+    NN_Start();
+    
+    tr.t[NN_TS_DMA_IN_START] = NN_Now();
+    if (NN_DmaSubmit(&tx_addr, tx_len, &rx_addr, rx_len, 1) < 0) {
+        return -1;
+    }
+    
+    /* Input streamed in */
+    if (NN_DmaWait(NN_DMA_TX, 1, deadline) < 0) {
+        goto hang;
+    }
+    tr.t[NN_TS_DMA_IN_END] = NN_Now();
+    
+    /* All layers evaluated */
+    if (nn_wait_state(NN_STATE_OUTPUT, deadline) < 0) {
+        goto hang;
+    }
+    tr.t[NN_TS_COMPUTE_DONE] = NN_Now();
+    
+    /* Results streamed out */
+    if (NN_DmaWait(NN_DMA_RX, 1, deadline) < 0) {
+        goto hang;
+    }
+    tr.t[NN_TS_DMA_OUT_END] = NN_Now();
+    
+    NN_CacheInvalidateRange(buf->out, rx_len);
+    tr.t[NN_TS_COMPLETE] = NN_Now();
+    
+    NN_StatsRecord(&tr);
+    nn_wd_learn(tr.t[NN_TS_DMA_OUT_END] - tr.t[NN_TS_DMA_IN_START]);
+    
+    g_timing.pack    = 0;
+    g_timing.cache   = (tr.t[NN_TS_DMA_IN_START] - tr.t[NN_TS_SUBMIT]) +
+                       (tr.t[NN_TS_COMPLETE] - tr.t[NN_TS_DMA_OUT_END]);
+    g_timing.dma_in  = tr.t[NN_TS_DMA_IN_END]   - tr.t[NN_TS_DMA_IN_START];
+    g_timing.compute = tr.t[NN_TS_COMPUTE_DONE] - tr.t[NN_TS_DMA_IN_END];
+    g_timing.dma_out = tr.t[NN_TS_DMA_OUT_END]  - tr.t[NN_TS_COMPUTE_DONE];
+    g_timing.total   = tr.t[NN_TS_COMPLETE]     - tr.t[NN_TS_SUBMIT];
+    
+    return 0;
+    
+hang:
+    /* The input buffer is untouched; recover and send it again */
+    if (nn_wd_hang(attempt) < 0) {
+        return -1;
+    }
+    g_wd.resubmits++;
+    attempt++;
+    goto retry;
+}
+
 int NN_RunInference(const s16 *inputs, u16 num_inputs,
                     s16 *outputs, u16 num_outputs)
 {
-    /* Check initialization */
-    if (!g_config.initialized) {
-        NN_Init(NULL);
+    XTime t_start, t_run, t_done, t_end;
+    NN_Buf *buf;
+    int ret;
+    
+    if (num_inputs > NN_MAX_INPUTS || num_outputs > NN_MAX_OUTPUTS) {
+        return -1;
+    }
+    
+    buf = NN_BufAlloc();
+    if (buf == NULL) {
+        return -1;
+    }
+    
+    XTime_GetTime(&t_start);
+    NN_BufPack(buf, inputs, num_inputs);
+    XTime_GetTime(&t_run);
+    
+    ret = NN_RunInferenceBuf(buf, num_inputs, num_outputs);
+    
+    XTime_GetTime(&t_done);
+    if (ret == 0) {
+        NN_BufUnpack(buf, outputs, num_outputs);
     }
+    XTime_GetTime(&t_end);
+    
+    NN_BufFree(buf);
+    
+    g_timing.pack  = (t_run - t_start) + (t_end - t_done);
+    g_timing.total = t_end - t_start;
+    
+    return ret;
+}
+
+int NN_ClassifyBuf(NN_Buf *buf, u16 num_inputs)
+{
+    NN_Trace tr;
+    XTime deadline;
+    const u32 tx_len = num_inputs * NN_AXIS_BEAT_BYTES;
+    u32 status;
+    int attempt = 0;
+    int ret = -1;
+    
+    tr.t[NN_TS_SUBMIT] = NN_Now();
+    
+    /* STATUS has four bits for the class */
+    if (nn_check_args(num_inputs, 0) < 0 ||
+        g_config.num_outputs > NN_MAX_OUTPUTS) {
+        return -1;
+    }
+    
+    /* Inputs only: the outputs never leave the core */
+    NN_CacheFlushRange(buf->in, tx_len);
+    nn_rearm();
+    nn_write_ctrl(NN_OP_MODE, g_ctrl | NN_CTRL_CLASS_ONLY);
+    
+retry:
+    deadline = nn_wd_deadline(attempt);
     
-    /* Start inference */
     NN_Start();
     
-    /* Note: In a full implementation, you would:
-     * 1. Send input data via AXI-Stream or DMA
-     * 2. Send weights/biases if not pre-loaded
-     * 3. Wait for completion
-     * 4. Read output data
-     *
-     * This simplified version assumes data transfer
-     * is handled separately.
-     */
+    tr.t[NN_TS_DMA_IN_START] = NN_Now();
+    if (NN_DmaSend((UINTPTR)buf->in, tx_len) < 0) {
+        goto out;
+    }
+    
+    /* START was taken (continuous or rearmed), so DONE dropped with it and
+     * once the input is in, DONE can only be this frame's */
+    if (NN_DmaWait(NN_DMA_TX, 1, deadline) < 0) {
+        goto hang;
+    }
+    tr.t[NN_TS_DMA_IN_END] = NN_Now();
+    
+    /* The read that sees DONE also carries the class */
+    while (!((status = nn_read(NN_OP_STATUS, NN_REG_STATUS)) & NN_STAT_DONE)) {
+        if (NN_Expired(deadline)) {
+            goto hang;
+        }
+    }
+    tr.t[NN_TS_COMPUTE_DONE] = NN_Now();
+    tr.t[NN_TS_DMA_OUT_END]  = tr.t[NN_TS_COMPUTE_DONE];
+    tr.t[NN_TS_COMPLETE]     = tr.t[NN_TS_COMPUTE_DONE];
+    
+    NN_StatsRecord(&tr);
+    nn_wd_learn(tr.t[NN_TS_COMPUTE_DONE] - tr.t[NN_TS_DMA_IN_START]);
+    
+    g_timing.pack    = 0;
+    g_timing.cache   = tr.t[NN_TS_DMA_IN_START]  - tr.t[NN_TS_SUBMIT];
+    g_timing.dma_in  = tr.t[NN_TS_DMA_IN_END]    - tr.t[NN_TS_DMA_IN_START];
+    g_timing.compute = tr.t[NN_TS_COMPUTE_DONE]  - tr.t[NN_TS_DMA_IN_END];
+    g_timing.dma_out = 0;
+    g_timing.total   = tr.t[NN_TS_COMPLETE]      - tr.t[NN_TS_SUBMIT];
+    
+    ret = (int)((status & NN_STAT_CLASS_MASK) >> NN_STAT_CLASS_SHIFT);
+    goto out;
+    
+hang:
+    /* NN_Recover() restores CTRL with CLASS_ONLY still set */
+    if (nn_wd_hang(attempt) == 0) {
+        g_wd.resubmits++;
+        attempt++;
+        goto retry;
+    }
+    
+out:
+    nn_write_ctrl(NN_OP_MODE, g_ctrl & ~NN_CTRL_CLASS_ONLY);
+    return ret;
+}
+
+int NN_ClassifyFast(const s16 *inputs, u16 num_inputs)
+{
+    XTime t_start, t_run, t_end;
+    NN_Buf *buf;
+    int ret;
+    
+    if (num_inputs > NN_MAX_INPUTS) {
+        return -1;
+    }
+    
+    buf = NN_BufAlloc();
+    if (buf == NULL) {
+        return -1;
+    }
+    
+    XTime_GetTime(&t_start);
+    NN_BufPack(buf, inputs, num_inputs);
+    XTime_GetTime(&t_run);
+    
+    ret = NN_ClassifyBuf(buf, num_inputs);
+    
+    XTime_GetTime(&t_end);
+    NN_BufFree(buf);
+    
+    g_timing.pack  = t_run - t_start;
+    g_timing.total = t_end - t_start;
+    
+    return ret;
+}
+
+int NN_RunBatchBuf(NN_Buf **bufs, u16 count, u16 num_inputs, u16 num_outputs)
+{
+    XTime t_start, t_flushed, t_out, t_end;
+    const u32 tx_len = num_inputs * NN_AXIS_BEAT_BYTES;
+    const u32 rx_len = num_outputs * NN_AXIS_BEAT_BYTES;
+    const u16 chain = NN_DmaHasSg() ? count : 1;
+    UINTPTR tx_addr[NN_MAX_BATCH];
+    UINTPTR rx_addr[NN_MAX_BATCH];
+    u16 done = 0;
+    int attempt = 0;
+    int ret = 0;
+    
+    if (nn_check_args(num_inputs, num_outputs) < 0) {
+        return -1;
+    }
+    if (count == 0 || count > NN_MAX_BATCH) {
+        return -1;
+    }
+    
+    XTime_GetTime(&t_start);
+    for (u16 f = 0; f < count; f++) {
+        tx_addr[f] = (UINTPTR)bufs[f]->in;
+        rx_addr[f] = (UINTPTR)bufs[f]->out;
+        NN_CacheFlushRange(bufs[f]->in, tx_len);
+        NN_CacheInvalidateRange(bufs[f]->out, rx_len);
+    }
+    XTime_GetTime(&t_flushed);
+    
+    /* Stream mode: each frame starts the core, no START/reset per image */
+    nn_write_ctrl(NN_OP_MODE, g_ctrl | NN_CTRL_ENABLE | NN_CTRL_STREAM);
+    
+    /* With a scatter-gather DMA the remaining frames are one descriptor
+     * chain per channel; in simple mode they go one at a time */
+    while (done < count) {
+        u16 n = (count - done < chain) ? count - done : chain;
+        u16 k = 0;
+        
+        if (nn_run_chain(&tx_addr[done], tx_len, &rx_addr[done], rx_len,
+                         n, &k, attempt) == 0) {
+            done += n;
+            attempt = 0;
+            continue;
+        }
+        
+        /* Frames that finished stay finished; the rest are sent again */
+        done += k;
+        attempt = (k > 0) ? 0 : attempt;
+        if (nn_wd_hang(attempt) < 0) {
+            ret = -1;
+            break;
+        }
+        g_wd.resubmits += count - done;
+        attempt++;
+    }
+    XTime_GetTime(&t_out);
+    
+    nn_write_ctrl(NN_OP_MODE, g_ctrl & ~NN_CTRL_STREAM);
+    
+    if (ret < 0) {
+        return -1;
+    }
+    
+    for (u16 f = 0; f < count; f++) {
+        NN_CacheInvalidateRange(bufs[f]->out, rx_len);
+    }
+    XTime_GetTime(&t_end);
+    
+    g_timing.pack    = 0;
+    g_timing.cache   = (t_flushed - t_start) + (t_end - t_out);
+    g_timing.dma_in  = 0;
+    g_timing.compute = t_out - t_flushed;
+    g_timing.dma_out = 0;
+    g_timing.total   = t_end - t_start;
+    
+    return 0;
+}
+
+int NN_RunBatch(const s16 *inputs, u16 num_inputs,
+                s16 *outputs, u16 num_outputs, u16 count)
+{
+    XTime t_start, t_run, t_done, t_end;
+    NN_Buf *bufs[NN_MAX_BATCH];
+    u16 n;
+    int ret = -1;
+    
+    if (count == 0 || count > NN_MAX_BATCH ||
+        num_inputs > NN_MAX_INPUTS || num_outputs > NN_MAX_OUTPUTS) {
+        return -1;
+    }
+    
+    XTime_GetTime(&t_start);
+    for (n = 0; n < count; n++) {
+        bufs[n] = NN_BufAlloc();
+        if (bufs[n] == NULL) {
+            goto out;
+        }
+        NN_BufPack(bufs[n], &inputs[n * num_inputs], num_inputs);
+    }
+    XTime_GetTime(&t_run);
+    
+    ret = NN_RunBatchBuf(bufs, count, num_inputs, num_outputs);
+    
+    XTime_GetTime(&t_done);
+    if (ret == 0) {
+        for (u16 f = 0; f < count; f++) {
+            NN_BufUnpack(bufs[f], &outputs[f * num_outputs], num_outputs);
+        }
+    }
+    XTime_GetTime(&t_end);
+    
+    g_timing.pack  = (t_run - t_start) + (t_end - t_done);
+    g_timing.total = t_end - t_start;
+    
+out:
+    while (n > 0) {
+        NN_BufFree(bufs[--n]);
+    }
+    return ret;
+}
+
+int NN_RunPipelined(const s16 *inputs, u16 num_inputs,
+                    s16 *outputs, u16 num_outputs, u32 count,
+                    NN_PipeReport *report)
+{
+    static NN_PipeReport scratch;
+    NN_PipeReport *r = (report != NULL) ? report : &scratch;
+    NN_Buf *bufs[NN_PIPE_DEPTH];
+    XTime queued_at[NN_PIPE_DEPTH];
+    XTime t0, t1, t2, prev_out, deadline;
+    const u32 tx_len = num_inputs * NN_AXIS_BEAT_BYTES;
+    const u32 rx_len = num_outputs * NN_AXIS_BEAT_BYTES;
+    const u16 depth = NN_DmaHasSg() ? NN_PIPE_DEPTH : 1;
+    u32 queued = 0, in_done = 0, done = 0;
+    u16 n = 0;
+    int attempt = 0;
+    int ret = -1;
+    
+    if (nn_check_args(num_inputs, num_outputs) < 0) {
+        return -1;
+    }
+    
+    memset(r, 0, sizeof(*r));
+    r->frames = count;
+    
+    for (n = 0; n < depth; n++) {
+        bufs[n] = NN_BufAlloc();
+        if (bufs[n] == NULL) {
+            goto out;
+        }
+    }
+    
+    /* Stream mode: each frame starts the core, no START per image */
+    nn_write_ctrl(NN_OP_MODE, g_ctrl | NN_CTRL_ENABLE | NN_CTRL_STREAM);
+    
+    XTime_GetTime(&t0);
+    prev_out = t0;
+    deadline = nn_wd_deadline(0);
+    
+    while (done < count) {
+        int k;
+        
+        /* Stage 1: keep up to depth frames queued on MM2S/S2MM */
+        if (queued < count && queued - done < depth) {
+            NN_Buf *buf = bufs[queued % depth];
+            UINTPTR tx_addr = (UINTPTR)buf->in;
+            UINTPTR rx_addr = (UINTPTR)buf->out;
+            
+            XTime_GetTime(&t1);
+            NN_BufPack(buf, &inputs[queued * num_inputs], num_inputs);
+            NN_CacheFlushRange(buf->in, tx_len);
+            NN_CacheInvalidateRange(buf->out, rx_len);
+            if (NN_DmaSubmit(&tx_addr, tx_len, &rx_addr, rx_len, 1) < 0) {
+                goto abort;
+            }
+            XTime_GetTime(&queued_at[queued % depth]);
+            
+            r->host_in += queued_at[queued % depth] - t1;
+            if (queued < NN_PIPE_TRACE) {
+                r->trace[queued].t[NN_TS_SUBMIT]       = t1;
+                r->trace[queued].t[NN_TS_DMA_IN_START] = queued_at[queued % depth];
+            }
+            queued++;
+            if (queued - done > r->depth) {
+                r->depth = (u16)(queued - done);
+            }
+            
+            /* The watchdog runs while the accelerator has work */
+            if (queued - done == 1) {
+                deadline = nn_wd_deadline(attempt);
+            }
+        }
+        
+        /* Stage 2 boundary: input frames accepted by the core */
+        if (in_done < queued) {
+            k = NN_DmaPoll(NN_DMA_TX);
+            if (k < 0) {
+                goto abort;
+            }
+            XTime_GetTime(&t1);
+            for (; k > 0; k--, in_done++) {
+                if (in_done < NN_PIPE_TRACE) {
+                    r->trace[in_done].t[NN_TS_DMA_IN_END] = t1;
+                }
+            }
+        }
+        
+        /* Stage 3: results back in memory, hand them to the caller */
+        if (done < queued) {
+            XTime t_seen;
+            
+            k = NN_DmaPoll(NN_DMA_RX);
+            if (k < 0) {
+                goto abort;
+            }
+            XTime_GetTime(&t_seen);
+            for (; k > 0; k--, done++) {
+                NN_Buf *buf = bufs[done % depth];
+                XTime t_in = queued_at[done % depth];
+                
+                /* Accelerator time, not counting the wait behind done-1 */
+                t1 = t_seen - ((t_in > prev_out) ? t_in : prev_out);
+                r->device += t1;
+                nn_wd_learn(t1);
+                prev_out = t_seen;
+                
+                XTime_GetTime(&t1);
+                NN_CacheInvalidateRange(buf->out, rx_len);
+                NN_BufUnpack(buf, &outputs[done * num_outputs], num_outputs);
+                XTime_GetTime(&t2);
+                r->host_out += t2 - t1;
+                
+                if (done < NN_PIPE_TRACE) {
+                    r->trace[done].t[NN_TS_COMPUTE_DONE] = t_seen;
+                    r->trace[done].t[NN_TS_DMA_OUT_END]  = t_seen;
+                    r->trace[done].t[NN_TS_COMPLETE]     = t2;
+                }
+                attempt  = 0;
+                deadline = nn_wd_deadline(0);
+            }
+        }
+        
+        /* Watchdog: recover and queue every unfinished frame again */
+        if (done < queued && NN_Expired(deadline)) {
+            if (nn_wd_hang(attempt) < 0) {
+                goto abort;
+            }
+            g_wd.resubmits += queued - done;
+            attempt++;
+            queued  = done;
+            in_done = done;
+        }
+    }
+    
+    XTime_GetTime(&t1);
+    r->wall = t1 - t0;
+    ret = 0;
     
-    /* Wait for completion (10 second timeout) */
-    if (NN_WaitDone(10000000) < 0) {
-        return -1;  /* Timeout */
+abort:
+    nn_write_ctrl(NN_OP_MODE, g_ctrl & ~NN_CTRL_STREAM);
+    if (ret < 0) {
+        NN_DmaAbort();
     }
     
-    /* In full implementation, read outputs here */
+out:
+    while (n > 0) {
+        NN_BufFree(bufs[--n]);
+    }
+    return ret;
+}
+
+void NN_SetIrqCoalesce(u16 count, u32 timeout_cycles)
+{
+    /* Timeout first, so the new count never runs with a stale timeout */
+    if (timeout_cycles != g_irq_timeout) {
+        g_irq_timeout = timeout_cycles;
+        nn_write(NN_OP_IRQ, NN_REG_IRQ_TIMEOUT, timeout_cycles);
+    } else {
+        g_mmio.skipped[NN_OP_IRQ]++;
+    }
+    
+    if (count != g_irq_count) {
+        g_irq_count = count;
+        nn_write(NN_OP_IRQ, NN_REG_IRQ_COUNT, count);
+    } else {
+        g_mmio.skipped[NN_OP_IRQ]++;
+    }
+}
+
+void NN_SetCompletionHandler(NN_CompletionHandler handler, void *ref)
+{
+    g_complete_cb  = handler;
+    g_complete_ref = ref;
+}
+
+void NN_IrqHandler(void *ref)
+{
+    u32 count;
+    
+    (void)ref;
+    
+    count = nn_read(NN_OP_IRQ, NN_REG_IRQ_STATUS);
+    if (count == 0) {
+        return;
+    }
+    
+    /* Acknowledge exactly what was read; later completions stay pending
+     * and raise the interrupt again */
+    nn_write(NN_OP_IRQ, NN_REG_IRQ_STATUS, count);
+    
+    if (g_complete_cb != NULL) {
+        g_complete_cb(count, g_complete_ref);
+    }
+}
+
+void NN_ModelInit(NN_Model *model)
+{
+    u32 hash = 2166136261u;
+    
+    hash = nn_fnv1a(hash, model->sizes, sizeof(model->sizes));
+    for (int l = 0; l < NN_WEIGHT_LAYERS; l++) {
+        u16 n_in  = model->sizes[l];
+        u16 n_out = model->sizes[l + 1];
+        
+        hash = nn_fnv1a(hash, model->weights[l], (u32)n_in * n_out * sizeof(s16));
+        hash = nn_fnv1a(hash, model->biases[l], (u32)n_out * sizeof(s16));
+    }
+    
+    /* 0 is reserved for the bitstream model / an interrupted upload */
+    model->hash = (hash != 0) ? hash : 1;
+}
+
+int NN_LoadModel(const NN_Model *model)
+{
+    XTime deadline;
+    u32 num_w = 0;
+    u32 n = 0;
+    
+    if (nn_check_args(0, 0) < 0) {
+        return -1;
+    }
+    
+    /* Resident model already matches: only the topology may need updating */
+    if (nn_read(NN_OP_MODEL, NN_REG_MODEL_HASH) == model->hash) {
+        NN_Configure(model->sizes[0], model->sizes[1],
+                     model->sizes[2], model->sizes[3]);
+        return 1;
+    }
+    
+    for (int l = 0; l < NN_WEIGHT_LAYERS; l++) {
+        num_w += (u32)model->sizes[l] * model->sizes[l + 1];
+    }
+    if (num_w > NN_MAX_WEIGHTS || model->sizes[0] > NN_MAX_INPUTS ||
+        model->sizes[1] + model->sizes[2] + model->sizes[3] > NN_MAX_BIASES) {
+        return -1;
+    }
+    
+    /* Same layer-major order as nn_model_weights.mem / nn_model_biases.mem */
+    for (int l = 0; l < NN_WEIGHT_LAYERS; l++) {
+        u32 count = (u32)model->sizes[l] * model->sizes[l + 1];
+        for (u32 i = 0; i < count; i++) {
+            g_model_buf[n++] = (u32)(s32)model->weights[l][i];
+        }
+    }
+    for (int l = 0; l < NN_WEIGHT_LAYERS; l++) {
+        for (u16 i = 0; i < model->sizes[l + 1]; i++) {
+            g_model_buf[n++] = (u32)(s32)model->biases[l][i];
+        }
+    }
+    
+    /* The staging buffer is outside the pool and always cacheable */
+    if (NN_BufPoolMode() != NN_BUF_COHERENT) {
+        Xil_DCacheFlushRange((INTPTR)g_model_buf, n * NN_AXIS_BEAT_BYTES);
+    }
+    
+    NN_Configure(model->sizes[0], model->sizes[1],
+                 model->sizes[2], model->sizes[3]);
+    if (num_w != g_num_w) {
+        g_num_w = (u16)num_w;
+        nn_write(NN_OP_MODEL, NN_REG_NUM_W, num_w);
+    }
+    
+    /* One beat per cycle, plus the usual watchdog margin */
+    XTime_GetTime(&deadline);
+    deadline += (XTime)(((u64)n * COUNTS_PER_SECOND) / NN_CLK_HZ) * NN_WD_MULT +
+                nn_wd_limit(0);
+    
+    /* A finished core outside continuous mode ignores LOAD + START and the
+     * beats would land in an input bank */
+    nn_rearm();
+    
+    /* LOAD + START clears MODEL_HASH in hardware until we tag it below */
+    g_ctrl |= NN_CTRL_ENABLE;
+    nn_write(NN_OP_MODEL, NN_REG_CTRL,
+             g_ctrl | NN_CTRL_LOAD_MODEL | NN_CTRL_START);
+    
+    if (NN_DmaSend((UINTPTR)g_model_buf, n * NN_AXIS_BEAT_BYTES) < 0 ||
+        NN_DmaWait(NN_DMA_TX, 1, deadline) < 0 ||
+        nn_wait_idle(deadline) < 0) {
+        /* MODEL_HASH stays 0, so the next call uploads again */
+        g_wd.hangs++;
+        NN_Recover();
+        return -1;
+    }
+    
+    nn_write(NN_OP_MODEL, NN_REG_MODEL_HASH, model->hash);
+    
+    return 0;
+}
+
+s16 NN_Activate(s16 x)
+{
+#if NN_ACTIVATION == NN_ACT_SIGMOID_LUT
+    s32 u = (s32)x + (8 << NN_FRAC_BITS);      /* x + 8.0 */
+    
+    if (!g_sig_lut_ready) {
+        for (int i = 0; i < NN_SIG_LUT_SIZE; i++) {
+            double v = (double)i / (NN_SIG_LUT_SIZE - 1) * 16.0 - 8.0;
+            g_sig_lut[i] = (s16)nearbyint(1.0 / (1.0 + exp(-v)) * NN_SCALE);
+        }
+        g_sig_lut_ready = 1;
+    }
+    if (u < 0) {
+        u = 0;
+    } else if (u > (16 << NN_FRAC_BITS) - 1) {
+        u = (16 << NN_FRAC_BITS) - 1;
+    }
+    return g_sig_lut[u >> (NN_FRAC_BITS + 4 - 10)];
+#elif NN_ACTIVATION == NN_ACT_SIGMOID_INTERP
+    s32 u = (s32)x + (8 << NN_FRAC_BITS);      /* x + 8.0 */
+    s32 k, f;
+    
+    if (u < 0) {
+        return g_sig_interp[0];
+    }
+    if (u >= (16 << NN_FRAC_BITS)) {
+        return g_sig_interp[NN_SIG_SEGS];
+    }
+    k = u >> NN_SIG_FRAC_W;
+    f = u & ((1 << NN_SIG_FRAC_W) - 1);
+    return (s16)(g_sig_interp[k] +
+                 (((g_sig_interp[k + 1] - g_sig_interp[k]) * f) >> NN_SIG_FRAC_W));
+#elif NN_ACTIVATION == NN_ACT_HARD_SIGMOID
+    s32 h = (x >> 2) + (1 << (NN_FRAC_BITS - 1));
+    
+    if (h < 0) {
+        return 0;
+    }
+    return (s16)((h > NN_SCALE) ? NN_SCALE : h);
+#else
+    return (x < 0) ? 0 : x;
+#endif
+}
+
+int NN_ModelReference(const NN_Model *model, const s16 *inputs, s16 *outputs)
+{
+    s16 act[2][NN_MAX_BIASES];
+    const s16 *in = inputs;
+    
+    if (model->sizes[0] > NN_MAX_INPUTS || model->sizes[3] > NN_MAX_OUTPUTS ||
+        model->sizes[1] + model->sizes[2] + model->sizes[3] > NN_MAX_BIASES) {
+        return -1;
+    }
+    
+    for (int l = 0; l < NN_WEIGHT_LAYERS; l++) {
+        u16 n_in = model->sizes[l];
+        s16 *out = (l == NN_WEIGHT_LAYERS - 1) ? outputs : act[l & 1];
+        
+        for (u16 n = 0; n < model->sizes[l + 1]; n++) {
+            const s16 *w = &model->weights[l][(u32)n * n_in];
+            /* Unsigned, so the sum wraps like the 32-bit accumulator */
+            u32 acc = (u32)(s32)model->biases[l][n] << NN_FRAC_BITS;
+            s32 sum;
+            
+            for (u16 i = 0; i < n_in; i++) {
+                acc += (u32)((s32)w[i] * in[i]);
+            }
+            sum = (s32)acc >> NN_FRAC_BITS;
+            if (sum > 32767) {
+                sum = 32767;
+            } else if (sum < -32768) {
+                sum = -32768;
+            }
+            out[n] = NN_Activate((s16)sum);
+        }
+        in = out;
+    }
     
     return 0;
 }
 
+void NN_GetLastTiming(NN_Timing *timing)
+{
+    *timing = g_timing;
+}
+
+void NN_GetMmioStats(NN_MmioStats *stats)
+{
+    *stats = g_mmio;
+}
+
+void NN_ClearMmioStats(void)
+{
+    memset(&g_mmio, 0, sizeof(g_mmio));
+}
+
 int NN_Classify(const s16 *outputs, u16 num_outputs)
 {
     int max_idx = 0;
@@ -11,6 +11,10 @@
 
 #include "xil_types.h"
 #include "xil_io.h"
+#include "xparameters.h"
+#include "xtime_l.h"
+#include "nn_regs.h"
+#include "nn_stats.h"
 
 /*==============================================================================
  * Base Address
@@ -21,29 +25,14 @@
 #endif
 
 /*==============================================================================
- * Register Offsets
+ * AXI DMA (axi_dma_0 in the block design)
  *============================================================================*/
-#define NN_REG_CTRL     0x00    /* Control register */
-#define NN_REG_STATUS   0x04    /* Status register (read-only) */
-#define NN_REG_NUM_IN   0x08    /* Number of inputs */
-#define NN_REG_NUM_H1   0x0C    /* Hidden layer 1 size */
-#define NN_REG_NUM_H2   0x10    /* Hidden layer 2 size */
-#define NN_REG_NUM_OUT  0x14    /* Number of outputs */
-
-/*==============================================================================
- * Control Register Bits
- *============================================================================*/
-#define NN_CTRL_ENABLE      (1 << 0)    /* Enable accelerator */
-#define NN_CTRL_START       (1 << 1)    /* Start inference (auto-clear) */
-#define NN_CTRL_SOFT_RESET  (1 << 2)    /* Soft reset */
+#ifndef NN_DMA_DEVICE_ID
+#define NN_DMA_DEVICE_ID    XPAR_AXIDMA_0_DEVICE_ID
+#endif
 
-/*==============================================================================
- * Status Register Bits
- *============================================================================*/
-#define NN_STAT_BUSY        (1 << 0)    /* Accelerator busy */
-#define NN_STAT_DONE        (1 << 1)    /* Inference complete */
-#define NN_STAT_STATE_MASK  (0xF << 4)  /* Current state */
-#define NN_STAT_STATE_SHIFT 4
+#define NN_CACHE_LINE       32          /* Cortex-A9 L1/L2 line size */
+#define NN_AXIS_BEAT_BYTES  4           /* One S.4.11 value per 32-bit beat */
 
 /*==============================================================================
  * Fixed-Point Conversion (S.4.11 format)
@@ -62,6 +51,53 @@
 #define NN_DEFAULT_NUM_H2   16
 #define NN_DEFAULT_NUM_OUT  10
 
+#define NN_MAX_INPUTS       784         /* nn_pkg::MAX_LAYER_SIZE */
+#define NN_MAX_OUTPUTS      16
+
+#define NN_WEIGHT_LAYERS    3
+#define NN_MAX_WEIGHTS      16384       /* nn_pkg::WEIGHT_MEM_DEPTH */
+#define NN_MAX_BIASES       64          /* nn_pkg::BIAS_MEM_DEPTH */
+
+/*==============================================================================
+ * Activation Function (must match nn_pkg::ACTIVATION)
+ *============================================================================*/
+#define NN_ACT_SIGMOID_LUT      0       /* 1024-entry ROM (sigmoid_lut.mem) */
+#define NN_ACT_SIGMOID_INTERP   1       /* 64 linear segments over [-8, +8) */
+#define NN_ACT_HARD_SIGMOID     2       /* clamp(x/4 + 0.5, 0, 1) */
+#define NN_ACT_RELU             3       /* max(x, 0) */
+
+#ifndef NN_ACTIVATION
+#define NN_ACTIVATION       NN_ACT_SIGMOID_LUT
+#endif
+
+#ifndef NN_MAX_BATCH
+#define NN_MAX_BATCH        64          /* Frames per DMA descriptor chain */
+#endif
+
+#ifndef NN_PIPE_DEPTH
+#define NN_PIPE_DEPTH       4           /* Frames in flight in NN_RunPipelined() */
+#endif
+
+#define NN_PIPE_TRACE       16          /* Frames with a full timeline */
+
+#define NN_INFERENCE_TIMEOUT_US 10000000 /* Hard cap on any watchdog limit */
+
+/*==============================================================================
+ * Hang Watchdog
+ * A frame is declared hung after NN_WD_MULT times its expected accelerator
+ * time plus NN_WD_SLACK_US; each retry of the same frame doubles the limit.
+ *============================================================================*/
+#ifndef NN_CLK_HZ
+#define NN_CLK_HZ           50000000    /* FCLK_CLK0 */
+#endif
+#define NN_PARALLEL         2           /* nn_pkg::NUM_PARALLEL */
+#define NN_IN_PARALLEL      4           /* nn_pkg::IN_PARALLEL */
+#define NN_MAC_PIPE_STAGES  4           /* nn_pkg::MAC_PIPE_STAGES, 2 + log2(IN_PARALLEL) */
+
+#define NN_WD_MULT          4
+#define NN_WD_SLACK_US      200         /* DMA start-up and bus jitter */
+#define NN_WD_RETRIES       2           /* Resubmissions before giving up */
+
 /*==============================================================================
  * Data Types
  *============================================================================*/
@@ -71,6 +107,7 @@ typedef struct {
     u16 num_hidden1;
     u16 num_hidden2;
     u16 num_outputs;
+    u16 dma_device_id;
     u8  initialized;
 } NN_Config;
 
@@ -78,8 +115,120 @@ typedef struct {
     u8  busy;
     u8  done;
     u8  state;
+    u8  predicted;      /* Hardware argmax, valid when done */
+    u8  in_ready;       /* An input bank can take the next frame */
+    u16 margin;         /* Top-2 margin of predicted (S.4.11), valid when done */
 } NN_Status;
 
+/**
+ * Per-phase latency of the last inference call, in global timer ticks
+ * (COUNTS_PER_SECOND). Use NN_TICKS_TO_US() to convert.
+ * For batch calls the fields cover the whole batch and compute also
+ * includes both streams (dma_in and dma_out are 0).
+ */
+typedef struct {
+    u64 pack;       /* Pack inputs / unpack outputs (0 for *Buf calls) */
+    u64 cache;      /* Ranged flush + invalidate of the DMA buffers */
+    u64 dma_in;     /* MM2S: input vector streamed into the core */
+    u64 compute;    /* Last input beat until core reaches S_OUTPUT */
+    u64 dma_out;    /* S2MM: results streamed back to memory */
+    u64 total;      /* Entry to exit of the inference call */
+} NN_Timing;
+
+/**
+ * Model image for NN_LoadModel(). Weights are one row per neuron
+ * ([out][in], as in nn_weights.h). Call NN_ModelInit() after filling
+ * the fields to compute the hash.
+ */
+typedef struct {
+    const s16 *weights[NN_WEIGHT_LAYERS];
+    const s16 *biases[NN_WEIGHT_LAYERS];
+    u16 sizes[NN_WEIGHT_LAYERS + 1];    /* Inputs, hidden 1, hidden 2, outputs */
+    u32 hash;                           /* Content hash, never 0 */
+} NN_Model;
+
+/**
+ * Completion callback, called from NN_IrqHandler() with the number of
+ * inferences that finished since the previous interrupt.
+ */
+typedef void (*NN_CompletionHandler)(u32 count, void *ref);
+
+/**
+ * Driver operations that touch accelerator registers, for MMIO accounting.
+ */
+typedef enum {
+    NN_OP_RESET = 0,    /* NN_Reset() */
+    NN_OP_CONFIGURE,    /* NN_Configure() */
+    NN_OP_START,        /* NN_Start() */
+    NN_OP_MODE,         /* Continuous / stream mode changes */
+    NN_OP_STATUS,       /* Status polling */
+    NN_OP_MODEL,        /* NN_LoadModel() */
+    NN_OP_IRQ,          /* Interrupt configuration and handling */
+    NN_OP_COUNT
+} NN_MmioOp;
+
+/**
+ * Register accesses issued by the driver since NN_ClearMmioStats().
+ * Writes that match the shadow copy are not issued and count as skipped.
+ */
+typedef struct {
+    u32 reads[NN_OP_COUNT];
+    u32 writes[NN_OP_COUNT];
+    u32 skipped[NN_OP_COUNT];
+} NN_MmioStats;
+
+/**
+ * Timeline of one NN_RunPipelined() call, in global timer ticks.
+ *
+ * Per frame, the accelerator time is counted from the later of its queueing
+ * and the previous frame's results, so it excludes time spent waiting
+ * behind that frame. With no overlap wall equals the sum of host_in,
+ * device and host_out; with full overlap wall approaches device alone.
+ *
+ * trace[] holds the first NN_PIPE_TRACE frames: SUBMIT = pack start,
+ * DMA_IN_START = descriptors queued, DMA_IN_END = MM2S done seen,
+ * COMPUTE_DONE = DMA_OUT_END = S2MM done seen, COMPLETE = unpacked.
+ */
+typedef struct {
+    u32      frames;
+    u16      depth;         /* Most frames in flight at once */
+    u64      wall;          /* First pack to last unpack */
+    u64      host_in;       /* Pack + flush + queue, summed over frames */
+    u64      device;        /* DMA in + compute + DMA out, summed */
+    u64      host_out;      /* Invalidate + unpack, summed */
+    NN_Trace trace[NN_PIPE_TRACE];
+} NN_PipeReport;
+
+/**
+ * Watchdog counters since NN_Init().
+ */
+typedef struct {
+    u32 hangs;          /* Frames that overran the watchdog limit */
+    u32 resubmits;      /* Frames queued again after a recovery */
+    u32 failures;       /* Calls that gave up after NN_WD_RETRIES */
+    u32 expected_us;    /* Current expected accelerator time per frame */
+    u32 limit_us;       /* Current watchdog limit (first attempt) */
+} NN_WdStats;
+
+#define NN_TICKS_TO_US(t)   ((u32)(((t) * 1000000ULL) / COUNTS_PER_SECOND))
+
+/*==============================================================================
+ * Timeout Helpers (global timer based)
+ *============================================================================*/
+static inline XTime NN_Deadline(u32 timeout_us)
+{
+    XTime now;
+    XTime_GetTime(&now);
+    return now + ((u64)timeout_us * COUNTS_PER_SECOND) / 1000000ULL;
+}
+
+static inline int NN_Expired(XTime deadline)
+{
+    XTime now;
+    XTime_GetTime(&now);
+    return now >= deadline;
+}
+
 /*==============================================================================
  * Function Prototypes
  *============================================================================*/
@@ -93,6 +242,8 @@ int NN_Init(NN_Config *config);
 
 /**
  * @brief Reset the NN accelerator
+ *
+ * Topology registers are kept; the shadow copies stay valid.
  */
 void NN_Reset(void);
 
@@ -125,9 +276,62 @@ void NN_GetStatus(NN_Status *status);
 
 /**
  * @brief Start inference
+ *
+ * Issues a single CTRL write built from the shadow copy; no register read.
  */
 void NN_Start(void);
 
+/**
+ * @brief Enable or disable continuous mode
+ *
+ * In continuous mode the core returns to idle after each inference with
+ * its configuration kept, so the next NN_Start() needs no NN_Reset().
+ * The setting survives NN_Reset().
+ *
+ * @param enable 1 to enable, 0 to disable
+ */
+void NN_SetContinuous(int enable);
+
+/**
+ * @brief Skip the activation function on the output layer
+ *
+ * The hardware argmax, score and margin then work on the raw output
+ * layer, as do the values streamed back. Activations never reorder
+ * outputs, so the class only changes where they flattened two outputs
+ * into a tie, and the margin no longer saturates with the sigmoid. The
+ * setting survives NN_Reset(); change it between inferences only.
+ *
+ * @param enable 1 for raw outputs, 0 for activated outputs
+ */
+void NN_SetRawOutput(int enable);
+
+/**
+ * @brief Get the score and top-2 margin of the last inference
+ *
+ * Computed in hardware as the output layer is stored, so they are also
+ * available after NN_ClassifyBuf(). Valid once done is set.
+ *
+ * @param score Output value of the predicted class (S.4.11), may be NULL
+ * @param margin Score minus the runner-up (S.4.11, unsigned), may be NULL
+ */
+void NN_GetScore(s16 *score, u16 *margin);
+
+/**
+ * @brief Recover from a hung accelerator
+ *
+ * Resets the DMA (dropping all descriptors), soft-resets the core and
+ * rewrites CTRL and the topology registers from the shadow copies. The
+ * inference calls do this themselves when the watchdog fires and then
+ * resubmit the unfinished frames.
+ */
+void NN_Recover(void);
+
+/**
+ * @brief Get watchdog counters and the current limits
+ * @param stats Pointer to stats structure
+ */
+void NN_GetWdStats(NN_WdStats *stats);
+
 /**
  * @brief Wait for inference to complete
  * @param timeout_us Timeout in microseconds (0 = infinite)
@@ -135,17 +339,176 @@ void NN_Start(void);
  */
 int NN_WaitDone(u32 timeout_us);
 
+/**
+ * @brief Initialize the AXI DMA (simple or scatter-gather, as built)
+ * @param device_id DMA device ID from xparameters.h
+ * @return 0 on success, -1 on failure
+ */
+int NN_DmaInit(u16 device_id);
+
 /**
  * @brief Run complete inference
+ *
+ * Packs the inputs into a pool buffer (see nn_buf.h), streams them to the
+ * core over MM2S, starts the accelerator and receives the results over
+ * S2MM. Unless continuous mode is on (NN_SetContinuous()), the core holds
+ * its results in S_DONE after each inference; the next call soft-resets
+ * it first, so callers never need NN_Reset() between inferences.
+ * Continuous mode saves that reset.
+ *
  * @param inputs Input data array (fixed-point)
- * @param num_inputs Number of inputs
+ * @param num_inputs Number of inputs (<= NN_MAX_INPUTS)
  * @param outputs Output data array (fixed-point)
- * @param num_outputs Number of outputs
+ * @param num_outputs Number of outputs (<= NN_MAX_OUTPUTS)
  * @return 0 on success, -1 on failure
  */
 int NN_RunInference(const s16 *inputs, u16 num_inputs,
                     s16 *outputs, u16 num_outputs);
 
+/**
+ * @brief Classify one image without reading the outputs back
+ *
+ * Only the predicted class is returned: the core skips the result stream
+ * and reports its argmax in STATUS (see NN_ClassifyBuf()). Ties go to the
+ * lowest index, as in NN_Classify().
+ *
+ * @param inputs Input data array (fixed-point)
+ * @param num_inputs Number of inputs (<= NN_MAX_INPUTS)
+ * @return Predicted class (0 to num_outputs-1), -1 on failure
+ */
+int NN_ClassifyFast(const s16 *inputs, u16 num_inputs);
+
+/**
+ * @brief Run a batch of inferences back to back
+ *
+ * Puts the core in stream mode so each input frame starts an inference.
+ * With a scatter-gather DMA the batch is one descriptor chain per channel,
+ * started by a single tail pointer write each; in simple mode the frames
+ * are transferred one at a time.
+ *
+ * @param inputs count input vectors, back to back (count * num_inputs)
+ * @param num_inputs Number of inputs per vector (<= NN_MAX_INPUTS)
+ * @param outputs count output vectors, back to back (count * num_outputs)
+ * @param num_outputs Number of outputs per vector (<= NN_MAX_OUTPUTS)
+ * @param count Number of vectors (1 to NN_MAX_BATCH)
+ * @return 0 on success, -1 on failure
+ */
+int NN_RunBatch(const s16 *inputs, u16 num_inputs,
+                s16 *outputs, u16 num_outputs, u16 count);
+
+/**
+ * @brief Run inferences as a three-stage pipeline
+ *
+ * Host input (pack, flush, queue), accelerator (MM2S, compute, S2MM) and
+ * host output (invalidate, unpack) run concurrently on up to
+ * NN_PIPE_DEPTH frames: while the core works on frame k, frame k+1 is
+ * already queued on MM2S and frame k-1's results are being unpacked.
+ * The core's second input bank takes frame k+1 during frame k's compute,
+ * so the input transfer drops out of the per-frame time.
+ * Throughput approaches one frame per accelerator time instead of one per
+ * host + accelerator time. Needs a scatter-gather DMA for more than one
+ * frame in flight; in simple mode the stages run one frame at a time.
+ *
+ * @param inputs count input vectors, back to back (count * num_inputs)
+ * @param num_inputs Number of inputs per vector (<= NN_MAX_INPUTS)
+ * @param outputs count output vectors, back to back (count * num_outputs)
+ * @param num_outputs Number of outputs per vector (<= NN_MAX_OUTPUTS)
+ * @param count Number of vectors (any)
+ * @param report Timeline of the run (can be NULL)
+ * @return 0 on success, -1 on failure
+ */
+int NN_RunPipelined(const s16 *inputs, u16 num_inputs,
+                    s16 *outputs, u16 num_outputs, u32 count,
+                    NN_PipeReport *report);
+
+/**
+ * @brief Configure interrupt coalescing
+ *
+ * The interrupt is raised once count completions are pending, or
+ * timeout_cycles accelerator clocks after the oldest pending completion,
+ * whichever comes first. count = 0 restores one level interrupt per DONE
+ * (not usable with NN_IrqHandler()).
+ *
+ * @param count Completions per interrupt
+ * @param timeout_cycles Flush timeout in cycles (0 = none)
+ */
+void NN_SetIrqCoalesce(u16 count, u32 timeout_cycles);
+
+/**
+ * @brief Set the callback run by NN_IrqHandler()
+ * @param handler Callback, or NULL for none
+ * @param ref Passed to the callback unchanged
+ */
+void NN_SetCompletionHandler(NN_CompletionHandler handler, void *ref);
+
+/**
+ * @brief Accelerator interrupt service routine
+ *
+ * Connect to the PL interrupt with XScuGic_Connect(). Reads and
+ * acknowledges every pending completion in one pass, then reports them
+ * to the completion handler.
+ *
+ * @param ref Unused (XScuGic callback reference)
+ */
+void NN_IrqHandler(void *ref);
+
+/**
+ * @brief Compute the content hash of a model
+ *
+ * Hashes the topology, weights and biases (FNV-1a). Call once per model;
+ * NN_LoadModel() only compares the stored hash.
+ *
+ * @param model Model with weights, biases and sizes filled in
+ */
+void NN_ModelInit(NN_Model *model);
+
+/**
+ * @brief Make a model resident in the accelerator
+ *
+ * Skips the upload when the MODEL_HASH register already matches. Otherwise
+ * programs the topology and streams weights then biases over MM2S in one
+ * transfer, and tags the accelerator with the model hash. No inference may
+ * be in flight. Outside continuous mode a core that has finished one
+ * (S_DONE) is soft-reset first, since it would ignore the load.
+ *
+ * @param model Model prepared with NN_ModelInit()
+ * @return 1 if already resident, 0 if uploaded, -1 on failure
+ */
+int NN_LoadModel(const NN_Model *model);
+
+/**
+ * @brief Apply the accelerator's activation function
+ *
+ * Bit-exact with the neurons for the NN_ACTIVATION option of the
+ * bitstream. NN_ACT_SIGMOID_LUT builds its table with exp() on first use.
+ *
+ * @param x Pre-activation (S.4.11, saturated MAC result)
+ * @return Activation (S.4.11)
+ */
+s16 NN_Activate(s16 x);
+
+/**
+ * @brief Run a model on the CPU, bit-exact with the accelerator
+ *
+ * Same arithmetic as the core with nn_pkg::MAC_ACC_WIDTH = 32: products
+ * accumulate onto the shifted bias with 32-bit wraparound, the sum is
+ * shifted back by NN_FRAC_BITS and saturated, then NN_Activate() is
+ * applied on every layer. A core built with MAC_ACC_WIDTH = 48 does not
+ * wrap there, so it differs wherever a sum leaves the 32-bit range.
+ *
+ * @param model Model with weights, biases and sizes filled in
+ * @param inputs Input vector (model->sizes[0] values)
+ * @param outputs Output vector (model->sizes[3] values)
+ * @return 0 on success, -1 if the topology exceeds the accelerator limits
+ */
+int NN_ModelReference(const NN_Model *model, const s16 *inputs, s16 *outputs);
+
+/**
+ * @brief Get per-phase latency of the last inference
+ * @param timing Pointer to timing structure
+ */
+void NN_GetLastTiming(NN_Timing *timing);
+
 /**
  * @brief Classify output (find max index)
  * @param outputs Output array
@@ -163,6 +526,17 @@ int NN_Classify(const s16 *outputs, u16 num_outputs);
  */
 float NN_GetConfidence(const s16 *outputs, u16 num_outputs, int class_idx);
 
+/**
+ * @brief Get MMIO access counters per driver operation
+ * @param stats Pointer to stats structure
+ */
+void NN_GetMmioStats(NN_MmioStats *stats);
+
+/**
+ * @brief Clear the MMIO access counters
+ */
+void NN_ClearMmioStats(void);
+
 /*==============================================================================
  * Low-Level Register Access Macros
  *============================================================================*/
@@ -0,0 +1,75 @@
+/**
+ * @file nn_regs.h
+ * @brief NN accelerator register map
+ *
+ * Plain definitions with no BSP dependencies, shared by the standalone
+ * driver and the Linux userspace library.
+ */
+
+#ifndef NN_REGS_H
+#define NN_REGS_H
+
+/*==============================================================================
+ * Register Offsets
+ *============================================================================*/
+#define NN_REG_CTRL     0x00    /* Control register */
+#define NN_REG_STATUS   0x04    /* Status register (read-only) */
+#define NN_REG_NUM_IN   0x08    /* Number of inputs */
+#define NN_REG_NUM_H1   0x0C    /* Hidden layer 1 size */
+#define NN_REG_NUM_H2   0x10    /* Hidden layer 2 size */
+#define NN_REG_NUM_OUT  0x14    /* Number of outputs */
+#define NN_REG_MODEL_HASH 0x18  /* Resident model ID (0 = bitstream model) */
+#define NN_REG_NUM_W    0x1C    /* Weight beats in a model upload */
+#define NN_REG_IRQ_COUNT   0x20 /* Completions per interrupt (0 = follow DONE) */
+#define NN_REG_IRQ_TIMEOUT 0x24 /* Cycles before a partial group interrupts */
+#define NN_REG_IRQ_STATUS  0x28 /* R: pending completions, W: acknowledge */
+#define NN_REG_SCORE       0x2C /* Score and top-2 margin of the class (read-only) */
+
+/*==============================================================================
+ * Control Register Bits
+ *============================================================================*/
+#define NN_CTRL_ENABLE      (1 << 0)    /* Enable accelerator */
+#define NN_CTRL_START       (1 << 1)    /* Start inference (auto-clear) */
+#define NN_CTRL_SOFT_RESET  (1 << 2)    /* Soft reset */
+#define NN_CTRL_STREAM      (1 << 3)    /* Start on input frame, rearm when done */
+#define NN_CTRL_CONTINUOUS  (1 << 4)    /* Rearm when done, keep configuration */
+#define NN_CTRL_LOAD_MODEL  (1 << 5)    /* With START: receive a model (auto-clear) */
+#define NN_CTRL_CLASS_ONLY  (1 << 6)    /* No result stream, class in STATUS */
+#define NN_CTRL_RAW_OUT     (1 << 7)    /* Output layer without activation */
+
+/*==============================================================================
+ * Status Register Bits
+ *============================================================================*/
+#define NN_STAT_BUSY        (1 << 0)    /* Accelerator busy */
+#define NN_STAT_DONE        (1 << 1)    /* Inference complete */
+#define NN_STAT_IN_READY    (1 << 2)    /* Input bank free, s_axis takes a frame */
+#define NN_STAT_STATE_MASK  (0xF << 4)  /* Current state */
+#define NN_STAT_STATE_SHIFT 4
+#define NN_STAT_CLASS_MASK  (0xF << 8)  /* Argmax of the outputs, valid with DONE */
+#define NN_STAT_CLASS_SHIFT 8
+#define NN_STAT_MARGIN_MASK (0xFFFFu << 16) /* Top-2 margin, valid with DONE */
+#define NN_STAT_MARGIN_SHIFT 16
+
+/*==============================================================================
+ * Score Register Fields
+ *============================================================================*/
+#define NN_SCORE_VAL_MASK     0xFFFFu           /* Predicted output (S.4.11) */
+#define NN_SCORE_MARGIN_MASK  (0xFFFFu << 16)   /* Score minus runner-up */
+#define NN_SCORE_MARGIN_SHIFT 16
+
+/*==============================================================================
+ * Accelerator FSM States (mirror nn_pkg::state_t)
+ *============================================================================*/
+#define NN_STATE_IDLE       0
+#define NN_STATE_LOAD_CFG   1
+#define NN_STATE_LOAD_IN    2
+#define NN_STATE_LOAD_W     3
+#define NN_STATE_LOAD_B     4
+#define NN_STATE_COMPUTE    5
+#define NN_STATE_ACTIVATE   6
+#define NN_STATE_STORE      7           /* Unused: stores overlap compute */
+#define NN_STATE_NEXT_LAYER 8
+#define NN_STATE_OUTPUT     9
+#define NN_STATE_DONE       10
+
+#endif /* NN_REGS_H */
@@ -0,0 +1,98 @@
+/**
+ * @file nn_ring.h
+ * @brief Single-producer/single-consumer ring of 32-bit entries
+ *
+ * Shared by the dual-core split on bare metal (one ring per direction in
+ * on-chip memory both A9 cores see) and the pinned-thread test on Linux.
+ * Each index is written by one side only and sits on its own cache line
+ * together with that side's cached copy of the other index, so a push or
+ * pop touches the other side's line only when the ring looks full/empty.
+ */
+
+#ifndef NN_RING_H
+#define NN_RING_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*==============================================================================
+ * Configuration
+ *============================================================================*/
+#define NN_RING_SIZE        64          /* Entries, power of two */
+#define NN_RING_LINE        64          /* Padding, covers A9 (32) and x86 (64) */
+
+/*==============================================================================
+ * Data Types
+ *============================================================================*/
+typedef struct {
+    /* Producer line */
+    uint32_t head __attribute__((aligned(NN_RING_LINE)));
+    uint32_t tail_seen;                 /* Last tail the producer read */
+
+    /* Consumer line */
+    uint32_t tail __attribute__((aligned(NN_RING_LINE)));
+    uint32_t head_seen;                 /* Last head the consumer read */
+
+    uint32_t entry[NN_RING_SIZE] __attribute__((aligned(NN_RING_LINE)));
+} NN_Ring;
+
+/*==============================================================================
+ * Functions
+ *============================================================================*/
+
+/**
+ * @brief Empty the ring (neither side may be using it)
+ * @param r Ring
+ */
+static inline void NN_RingInit(NN_Ring *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+/**
+ * @brief Append one entry (producer side only)
+ * @param r Ring
+ * @param val Entry
+ * @return 0 on success, -1 if the ring is full
+ */
+static inline int NN_RingPush(NN_Ring *r, uint32_t val)
+{
+    uint32_t head = r->head;
+
+    if (head - r->tail_seen == NN_RING_SIZE) {
+        r->tail_seen = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        if (head - r->tail_seen == NN_RING_SIZE) {
+            return -1;
+        }
+    }
+
+    r->entry[head & (NN_RING_SIZE - 1)] = val;
+    /* Publishes the entry and everything written before it */
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Remove the oldest entry (consumer side only)
+ * @param r Ring
+ * @param val Receives the entry
+ * @return 0 on success, -1 if the ring is empty
+ */
+static inline int NN_RingPop(NN_Ring *r, uint32_t *val)
+{
+    uint32_t tail = r->tail;
+
+    if (tail == r->head_seen) {
+        r->head_seen = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        if (tail == r->head_seen) {
+            return -1;
+        }
+    }
+
+    *val = r->entry[tail & (NN_RING_SIZE - 1)];
+    /* The producer may reuse the entry from here on */
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+#endif /* NN_RING_H */
@@ -0,0 +1,218 @@
+/**
+ * @file nn_stats.c
+ * @brief Per-phase latency histograms
+ */
+
+#include "nn_stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <stdio.h>
+#define NN_PRINTF   printf
+#else
+#include "xil_printf.h"
+#define NN_PRINTF   xil_printf
+#endif
+
+/*==============================================================================
+ * Module Variables
+ *============================================================================*/
+static NN_Hist g_hist[NN_PHASE_COUNT];
+static int     g_enabled = 1;
+
+/* Ring of the last end-to-end latencies, and a scratch copy to sort */
+static uint32_t g_samples[NN_STATS_SAMPLES];
+static uint32_t g_sorted[NN_STATS_SAMPLES];
+static uint32_t g_num_samples;          /* Total recorded, wraps the ring */
+
+static const char *const g_phase_names[NN_PHASE_COUNT] = {
+    "setup", "dma_in", "compute", "dma_out", "deliver", "total"
+};
+
+/*==============================================================================
+ * Local Helpers
+ *============================================================================*/
+
+static inline unsigned nn_bucket(uint64_t v)
+{
+    unsigned b;
+
+    if (v == 0) {
+        return 0;
+    }
+    b = 64 - (unsigned)__builtin_clzll(v);
+    return (b < NN_HIST_BUCKETS) ? b : NN_HIST_BUCKETS - 1;
+}
+
+static inline void nn_hist_add(NN_Hist *h, uint64_t v)
+{
+    h->bucket[nn_bucket(v)]++;
+    h->sum += v;
+    if (h->count == 0 || v < h->min) {
+        h->min = v;
+    }
+    if (v > h->max) {
+        h->max = v;
+    }
+    h->count++;
+}
+
+/* xil_printf has no 64-bit formats; microseconds fit in 32 bits */
+static uint32_t nn_us(uint64_t ticks)
+{
+    return (uint32_t)(NN_TS_TO_NS(ticks) / 1000ULL);
+}
+
+/* Tenths of a microsecond, printed as %d.%d */
+static uint32_t nn_us10(uint64_t ticks)
+{
+    return (uint32_t)(NN_TS_TO_NS(ticks) / 100ULL);
+}
+
+static int nn_cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Sort the retained samples into g_sorted, return how many there are */
+static uint32_t nn_sort_samples(void)
+{
+    uint32_t n = (g_num_samples < NN_STATS_SAMPLES) ? g_num_samples : NN_STATS_SAMPLES;
+
+    memcpy(g_sorted, g_samples, n * sizeof(g_sorted[0]));
+    qsort(g_sorted, n, sizeof(g_sorted[0]), nn_cmp_u32);
+    return n;
+}
+
+static uint32_t nn_rank(uint32_t n, uint32_t permille)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)n * permille + 999) / 1000);
+
+    return (rank > 0) ? rank - 1 : 0;
+}
+
+static uint64_t nn_mean(NN_Phase phase)
+{
+    const NN_Hist *h = &g_hist[phase];
+
+    return (h->count > 0) ? h->sum / h->count : 0;
+}
+
+/*==============================================================================
+ * Function Implementations
+ *============================================================================*/
+
+void NN_StatsEnable(int enable)
+{
+    g_enabled = enable;
+}
+
+void NN_StatsRecord(const NN_Trace *trace)
+{
+#if NN_STATS
+    uint64_t total;
+
+    if (!g_enabled) {
+        return;
+    }
+
+    for (int p = NN_PHASE_SETUP; p <= NN_PHASE_DELIVER; p++) {
+        nn_hist_add(&g_hist[p], trace->t[p + 1] - trace->t[p]);
+    }
+    total = trace->t[NN_TS_COMPLETE] - trace->t[NN_TS_SUBMIT];
+    nn_hist_add(&g_hist[NN_PHASE_TOTAL], total);
+    g_samples[g_num_samples++ % NN_STATS_SAMPLES] =
+        (total < UINT32_MAX) ? (uint32_t)total : UINT32_MAX;
+#else
+    (void)trace;
+#endif
+}
+
+void NN_StatsGet(NN_Phase phase, NN_Hist *hist)
+{
+    *hist = g_hist[phase];
+}
+
+void NN_StatsReset(void)
+{
+    memset(g_hist, 0, sizeof(g_hist));
+    g_num_samples = 0;
+}
+
+void NN_StatsDump(void)
+{
+    NN_PRINTF("Latency (us)   count      min      avg      max\r\n");
+
+    for (int p = 0; p < NN_PHASE_COUNT; p++) {
+        const NN_Hist *h = &g_hist[p];
+
+        if (h->count == 0) {
+            NN_PRINTF("  %-8s %7d\r\n", g_phase_names[p], 0);
+            continue;
+        }
+
+        NN_PRINTF("  %-8s %7d %8d %8d %8d\r\n", g_phase_names[p],
+                  (int)h->count, (int)nn_us(h->min),
+                  (int)nn_us(h->sum / h->count), (int)nn_us(h->max));
+
+        for (int b = 0; b < NN_HIST_BUCKETS; b++) {
+            if (h->bucket[b] == 0) {
+                continue;
+            }
+            /* Upper bound of the bucket in nanoseconds */
+            NN_PRINTF("      < %8d ns: %d\r\n",
+                      (int)NN_TS_TO_NS(1ULL << b), (int)h->bucket[b]);
+        }
+    }
+}
+
+uint64_t NN_StatsPercentile(uint32_t permille)
+{
+    uint32_t n = nn_sort_samples();
+
+    return (n > 0) ? g_sorted[nn_rank(n, permille)] : 0;
+}
+
+void NN_StatsReport(uint32_t frames, nn_ts_t wall)
+{
+    static const uint32_t pct[] = { 500, 900, 990, 1000 };
+    static const char *const pct_names[] = { "p50", "p90", "p99", "max" };
+    static const char *const split_names[] = { "driver", "dma", "compute" };
+    uint64_t split[3];
+    uint64_t sum;
+    uint32_t rate10, n;
+
+    rate10 = (wall > 0) ?
+        (uint32_t)((uint64_t)frames * NN_TS_PER_SEC * 10 / wall) : 0;
+    NN_PRINTF("Benchmark: %d inferences in %d ms, %d.%d inferences/s\r\n",
+              (int)frames, (int)(nn_us(wall) / 1000),
+              (int)(rate10 / 10), (int)(rate10 % 10));
+
+    n = nn_sort_samples();
+    NN_PRINTF("  Latency (us, last %d):", (int)n);
+    for (unsigned i = 0; i < sizeof(pct) / sizeof(pct[0]); i++) {
+        uint32_t v = (n > 0) ? nn_us10(g_sorted[nn_rank(n, pct[i])]) : 0;
+
+        NN_PRINTF(" %s=%d.%d", pct_names[i], (int)(v / 10), (int)(v % 10));
+    }
+    NN_PRINTF("\r\n");
+
+    /* Mean time per inference in each part of the path */
+    split[0] = nn_mean(NN_PHASE_SETUP) + nn_mean(NN_PHASE_DELIVER);
+    split[1] = nn_mean(NN_PHASE_DMA_IN) + nn_mean(NN_PHASE_DMA_OUT);
+    split[2] = nn_mean(NN_PHASE_COMPUTE);
+    sum = split[0] + split[1] + split[2];
+
+    NN_PRINTF("  Split (us):");
+    for (unsigned i = 0; i < 3; i++) {
+        uint32_t v = nn_us10(split[i]);
+
+        NN_PRINTF(" %s=%d.%d (%d%%)", split_names[i], (int)(v / 10), (int)(v % 10),
+                  (int)(sum ? split[i] * 100 / sum : 0));
+    }
+    NN_PRINTF("\r\n");
+}
@@ -0,0 +1,159 @@
+/**
+ * @file nn_stats.h
+ * @brief Per-phase latency timestamps and histograms
+ *
+ * Shared by the standalone and Linux drivers. Timestamps come from the
+ * ARM global timer on bare metal and CLOCK_MONOTONIC on Linux. Each
+ * recorded inference costs six timer reads and a few increments, so the
+ * statistics can stay enabled in production builds.
+ */
+
+#ifndef NN_STATS_H
+#define NN_STATS_H
+
+#include <stdint.h>
+
+#ifdef __linux__
+#include <time.h>
+#else
+#include "xtime_l.h"
+#endif
+
+/*==============================================================================
+ * Configuration
+ *============================================================================*/
+#ifndef NN_STATS
+#define NN_STATS            1           /* 0 compiles recording out */
+#endif
+
+#define NN_HIST_BUCKETS     32          /* log2 buckets, see NN_Hist */
+
+#ifndef NN_STATS_SAMPLES
+#define NN_STATS_SAMPLES    4096        /* Last totals kept for percentiles */
+#endif
+
+/*==============================================================================
+ * Timestamps
+ *============================================================================*/
+#ifdef __linux__
+#define NN_TS_PER_SEC       1000000000ULL
+#else
+#define NN_TS_PER_SEC       ((uint64_t)COUNTS_PER_SECOND)
+#endif
+
+#define NN_TS_TO_NS(t)      ((uint64_t)(t) * 1000000000ULL / NN_TS_PER_SEC)
+
+typedef uint64_t nn_ts_t;
+
+static inline nn_ts_t NN_Now(void)
+{
+#ifdef __linux__
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (nn_ts_t)ts.tv_sec * 1000000000ULL + (nn_ts_t)ts.tv_nsec;
+#else
+    XTime t;
+    XTime_GetTime(&t);
+    return (nn_ts_t)t;
+#endif
+}
+
+/*==============================================================================
+ * Data Types
+ *============================================================================*/
+
+/** Points in the life of one inference */
+typedef enum {
+    NN_TS_SUBMIT = 0,   /* Caller entered the driver */
+    NN_TS_DMA_IN_START, /* Buffers flushed, core started, MM2S queued */
+    NN_TS_DMA_IN_END,   /* Last input beat accepted */
+    NN_TS_COMPUTE_DONE, /* Core reached S_OUTPUT */
+    NN_TS_DMA_OUT_END,  /* Last result beat written */
+    NN_TS_COMPLETE,     /* Results visible to the caller */
+    NN_TS_COUNT
+} NN_TsPoint;
+
+/** Intervals between consecutive points, plus the end-to-end total */
+typedef enum {
+    NN_PHASE_SETUP = 0, /* SUBMIT -> DMA_IN_START */
+    NN_PHASE_DMA_IN,    /* DMA_IN_START -> DMA_IN_END */
+    NN_PHASE_COMPUTE,   /* DMA_IN_END -> COMPUTE_DONE */
+    NN_PHASE_DMA_OUT,   /* COMPUTE_DONE -> DMA_OUT_END */
+    NN_PHASE_DELIVER,   /* DMA_OUT_END -> COMPLETE */
+    NN_PHASE_TOTAL,     /* SUBMIT -> COMPLETE */
+    NN_PHASE_COUNT
+} NN_Phase;
+
+typedef struct {
+    nn_ts_t t[NN_TS_COUNT];
+} NN_Trace;
+
+/**
+ * Latency histogram in timestamp ticks. Bucket 0 holds 0, bucket b holds
+ * [2^(b-1), 2^b); the last bucket also takes everything above.
+ */
+typedef struct {
+    uint32_t bucket[NN_HIST_BUCKETS];
+    uint32_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+} NN_Hist;
+
+/*==============================================================================
+ * Function Prototypes
+ *============================================================================*/
+
+/**
+ * @brief Enable or disable recording at run time (enabled by default)
+ * @param enable 1 to record, 0 to ignore NN_StatsRecord()
+ */
+void NN_StatsEnable(int enable);
+
+/**
+ * @brief Add one inference to the histograms
+ * @param trace Timestamps for every NN_TsPoint
+ */
+void NN_StatsRecord(const NN_Trace *trace);
+
+/**
+ * @brief Get the histogram for one phase
+ * @param phase Phase to read
+ * @param hist Pointer to histogram structure
+ */
+void NN_StatsGet(NN_Phase phase, NN_Hist *hist);
+
+/**
+ * @brief Clear all histograms
+ */
+void NN_StatsReset(void);
+
+/**
+ * @brief Print count, min/avg/max and non-empty buckets for every phase
+ */
+void NN_StatsDump(void);
+
+/**
+ * @brief Exact end-to-end latency percentile
+ *
+ * Nearest rank over the last NN_STATS_SAMPLES recorded totals. Sorts a
+ * copy of the samples, so keep it out of the inference loop.
+ *
+ * @param permille Percentile in 1/1000 (500 = median, 1000 = max)
+ * @return Latency in timestamp ticks, 0 if nothing was recorded
+ */
+uint64_t NN_StatsPercentile(uint32_t permille);
+
+/**
+ * @brief Print a benchmark summary
+ *
+ * Throughput over the wall time, p50/p90/p99/max of the end-to-end
+ * latency and the mean split between driver (setup + deliver), DMA
+ * (dma_in + dma_out) and compute.
+ *
+ * @param frames Inferences completed in the run
+ * @param wall Wall time of the run in timestamp ticks
+ */
+void NN_StatsReport(uint32_t frames, nn_ts_t wall);
+
+#endif /* NN_STATS_H */